@@ -122,6 +122,20 @@ LoopFillZerobss:
   cmp r2, r3
   bcc FillZerobss
 
+#ifdef ENABLE_STACK_PAINT
+/* Fill the free stack area with a pattern for StackMonitor (util/util_stack_monitor.h) */
+  ldr  r2, =_sstack
+  ldr  r3, =0xa5a5a5a5
+  mov  r1, sp
+  b  LoopPaintStack
+PaintStack:
+  str  r3, [r2]
+  adds r2, r2, #4
+LoopPaintStack:
+  cmp  r2, r1
+  bcc  PaintStack
+#endif
+
 /* Call the clock system intitialization function.*/
     bl  SystemInit
 
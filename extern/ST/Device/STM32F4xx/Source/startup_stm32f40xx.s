@@ -131,6 +131,23 @@ LoopFillZeroCCMZ:
   cmp  r2, r3
   bcc  FillZeroCCMZ
 
+#ifdef ENABLE_STACK_PAINT
+/* Fill the free stack area with a pattern for StackMonitor (util/util_stack_monitor.h) */
+#ifdef ENABLE_CCM_STACK
+  ldr  r2, =_sccmstack
+#else
+  ldr  r2, =_sstack
+#endif
+  ldr  r3, =0xa5a5a5a5
+  mov  r1, sp
+  b  LoopPaintStack
+PaintStack:
+  str  r3, [r2], #4
+LoopPaintStack:
+  cmp  r2, r1
+  bcc  PaintStack
+#endif
+
 /* Call the clock system intitialization function.*/
   bl  SystemInit   
 
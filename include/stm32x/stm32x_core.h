@@ -26,6 +26,7 @@
 #define STM32X_CORE_H_
 
 #include "stm32x.h"
+#include "util/util_timebase.h"
 
 namespace stm32x {
 // GPIO forward declarations
@@ -35,6 +36,15 @@ enum struct GPIO_SPEED : uint8_t;
 enum struct GPIO_OTYPE : uint8_t;
 enum struct GPIO_PUPD : uint8_t;
 
+// SysTick as the sub-tick timer for Timebase
+struct SysTickTimer {
+  static constexpr uint32_t kMaxLoad = SysTick_LOAD_RELOAD_Msk;
+  static inline uint32_t value() { return SysTick->VAL; }
+  // Reading CTRL clears COUNTFLAG, so only the timebase (and Core::TicklessIdle, which passes an
+  // expiry on with SetReloadPending) may read it while it runs.
+  static inline bool reloaded() { return SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk; }
+};
+
 // Core timing and other functionality common to all platforms
 class Core {
 public:
@@ -43,9 +53,23 @@ public:
 
   void Init(uint32_t systick_ticks);
 
-  void Tick() { ++ticks_; }
+  void Tick() { timebase_.Tick(); }
+
+  inline uint32_t now() const volatile { return timebase_.now(); }
+
+  // Free-running cycle count from ticks and SysTick->VAL, wrapping at 2^32 like DWT->CYCCNT.
+  // The SysTick ISR must not be held off for more than a tick period (see util_timebase.h).
+  inline uint32_t cycles() const { return timebase_.cycles(); }
+
+  // 64-bit monotonic time since Init with SysTick resolution
+  inline uint64_t now_cycles() const { return timebase_.now_cycles(); }
+  inline uint64_t now_us() const { return timebase_.now_us(); }
 
-  inline uint32_t now() const volatile { return ticks_; }
+  // Sleep with WFI for up to idle_ticks (e.g. Scheduler::ticks_until_next()) with SysTick
+  // reprogrammed to fire only at the end, so there are no tick interrupts in between. Any other
+  // interrupt ends the sleep early; now() is corrected either way. Returns immediately if a tick
+  // is already pending.
+  void TicklessIdle(uint32_t idle_ticks);
 
   void Delay(uint32_t ticks)
   {
@@ -53,11 +77,42 @@ public:
     while ((now() - start) < ticks) {}
   }
 
+  // Deadline variants don't accumulate drift when called periodically with deadline += period
+  void DelayUntil(uint32_t deadline_ticks)
+  {
+    while (static_cast<int32_t>(deadline_ticks - now()) > 0) {}
+  }
+
+  void DelayUntilUs(uint64_t deadline_us)
+  {
+    const uint64_t deadline_cycles = deadline_us * timebase_.cycles_per_us();
+    while (now_cycles() < deadline_cycles) {}
+  }
+
 private:
-  volatile uint32_t ticks_ = 0;
+  Timebase<SysTickTimer> timebase_;
 };
 
 extern Core core;
+
+// Tick clock policy, e.g. for Scheduler
+struct CoreTicks {
+  static inline uint32_t now() { return core.now(); }
+};
+
+// Mask interrupts for the lifetime of the object, restoring the previous state (so it nests).
+// Keep the scope short; this is the Lock for e.g. util::LogBuffer with producers in ISRs.
+class ScopedIrqLock {
+public:
+  DELETE_COPY_MOVE(ScopedIrqLock);
+
+  ScopedIrqLock() : primask_(__get_PRIMASK()) { __disable_irq(); }
+  ~ScopedIrqLock() { __set_PRIMASK(primask_); }
+
+private:
+  const uint32_t primask_;
+};
+
 }  // namespace stm32x
 
 #define STM32X_CORE_DEFINE(attr) \
@@ -0,0 +1,75 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Coroutine awaitables for peripherals (see util/util_coroutine.h)
+//
+//   stm32x::FrameSlab<128, 2> spi_frames;
+//   stm32x::IrqCoExecutor<4> executor;
+//   stm32x::IrqSignal<decltype(executor)> dma_complete{executor};  // Set() in the DMA ISR
+//   stm32x::TimerWheel<stm32x::CoreTicks> wheel;
+//
+//   stm32x::CoTask<spi_frames> WritePage(...)
+//   {
+//     StartDma(...);
+//     co_await dma_complete;
+//     co_await stm32x::CoDelay{wheel, 2};
+//     co_await stm32x::FlashReady(wheel);
+//   }
+//
+//   for (;;) { executor.Run(); wheel.Dispatch(); ... }
+
+#ifndef STM32X_COROUTINE_H_
+#define STM32X_COROUTINE_H_
+
+#include "stm32x.h"
+#include "stm32x_core.h"
+#include "util/util_coroutine.h"
+
+#if __cpp_impl_coroutine
+
+namespace stm32x {
+
+template <size_t size>
+using IrqCoExecutor = CoExecutor<size, ScopedIrqLock>;
+
+template <typename Executor>
+using IrqSignal = CoSignal<Executor, ScopedIrqLock>;
+
+struct FlashNotBusy {
+  bool operator()() const { return !(FLASH->SR & FLASH_SR_BSY); }
+};
+
+// Wait for a flash program/erase operation to finish
+template <typename Wheel>
+inline auto FlashReady(Wheel &timer_wheel)
+{
+  return CoWaitUntil<Wheel, FlashNotBusy>{timer_wheel, FlashNotBusy{}};
+}
+
+}  // namespace stm32x
+
+#endif  // __cpp_impl_coroutine
+
+#endif  // STM32X_COROUTINE_H_
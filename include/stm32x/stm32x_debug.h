@@ -28,24 +28,44 @@
 #ifndef STM32X_DEBUG_H_
 #define STM32X_DEBUG_H_
 
+#include <string.h>
+
 #include <algorithm>
 
-#if defined STM32X_F0XX
-#error "DEBUG INTERFACE NOT SUPPORTED ON M0"
-#else
 #include "stm32x.h"
+#include "stm32x_core.h"
 #include "stm32x_math.h"
+#include "util/util_cpu_load.h"
+#include "util/util_cycle_histogram.h"
+#include "util/util_event_counters.h"
+#include "util/util_latency_monitor.h"
+#include "util/util_pc_sampler.h"
+#include "util/util_profiler.h"
 
 namespace stm32x {
 
+// Free-running 32-bit cycle counter. M0 has no DWT, so F0 derives it from SysTick and the core
+// ticks (see Core::cycles) which requires STM32X_CORE_INIT instead of STM32X_DEBUG_INIT.
+#if defined STM32X_F0XX
+struct CycleCounter {
+  static inline uint32_t now() { return core.cycles(); }
+};
+#else
+struct CycleCounter {
+  static inline uint32_t now() { return DWT->CYCCNT; }
+};
+#endif
+
 class Debug {
 public:
   static void Init()
   {
+#ifndef STM32X_F0XX
     CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
     ITM->LAR = 0xC5ACCE55;
     DWT->CYCCNT = 0;
     DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
   }
 };
 
@@ -60,9 +80,9 @@ class CycleMeasurement {
 public:
   DELETE_COPY_MOVE(CycleMeasurement);
 
-  CycleMeasurement() : start_(DWT->CYCCNT) {}
+  CycleMeasurement() : start_(CycleCounter::now()) {}
 
-  uint32_t read() const { return DWT->CYCCNT - start_; }
+  uint32_t read() const { return CycleCounter::now() - start_; }
 
 private:
   uint32_t start_;
@@ -96,18 +116,179 @@ private:
   uint32_t max_ = 0;
 };
 
+// Destination is anything with Push(uint32_t cycles), e.g. AveragedCycles or CycleHistogram
+template <typename Destination = AveragedCycles>
 class ScopedCycleMeasurement {
 public:
-  ScopedCycleMeasurement(AveragedCycles &dest) : dest_(dest) {}
+  ScopedCycleMeasurement(Destination &dest) : dest_(dest) {}
 
   ~ScopedCycleMeasurement() { dest_.Push(cycles_.read()); }
 
 private:
-  AveragedCycles &dest_;
+  Destination &dest_;
   CycleMeasurement cycles_;
 };
 
+// Measure the rest of the current scope into a zone defined with STM32X_PROFILE_ZONE(name)
+#define STM32X_PROFILE_SCOPE(name)                               \
+  stm32x::ScopedCycleMeasurement<stm32x::ProfilingZoneStats> CONCAT( \
+      stm32x_profile_scope_, __LINE__)(STM32X_PROFILE_ZONE_STATS(name))
+
+template <size_t levels>
+using CpuLoadMonitor = CpuLoad<CycleCounter, levels, ScopedIrqLock>;
+
+// Sleep until the next interrupt and account the time as idle. Interrupts are masked so the ISR
+// that wakes the core only runs after the idle time has been recorded.
+template <typename Load>
+inline void Idle(Load &load)
+{
+  ScopedIrqLock lock;
+  load.Idle([] { __WFI(); });
+}
+
+// Timestamp source for util::EventTrace
+struct CycleTraceSource {
+  static inline uint32_t now() { return CycleCounter::now(); }
+  static inline uint8_t context() { return static_cast<uint8_t>(__get_IPSR()); }
+};
+
+// Timer interrupt handler for PcSampler: reads the interrupted PC from the exception frame (on MSP
+// or PSP) and tail-calls `extern "C" void function(uint32_t pc)`, which should acknowledge the timer
+// and push the PC. Only uses M0 instructions.
+#define STM32X_PC_SAMPLER_HANDLER(handler, function) \
+  extern "C" void function(uint32_t pc);             \
+  extern "C" __attribute__((naked)) void handler()   \
+  {                                                  \
+    __asm__ volatile(                                \
+        "movs r0, #4\n"                              \
+        "mov r1, lr\n"                               \
+        "tst r0, r1\n"                               \
+        "beq 1f\n"                                   \
+        "mrs r0, psp\n"                              \
+        "b 2f\n"                                     \
+        "1: mrs r0, msp\n"                           \
+        "2: ldr r0, [r0, #24]\n"                     \
+        "ldr r1, =" #function "\n"                   \
+        "bx r1\n"                                    \
+        ".ltorg\n");                                 \
+  }
+
+// Periodic update interrupt for LatencyMonitor. The timer clock is enabled by the application;
+// with the timer at the CPU clock the counter value read in the handler is the entry latency in
+// cycles. The period should be well above the worst case latency since a wrapped counter can't be
+// detected. The handler should call Sample first thing:
+//   extern "C" void TIM14_IRQHandler() { latency_timer.Sample(latency_monitor); }
+template <uint32_t timx_base>
+struct LatencyTimer {
+  inline static TIM_TypeDef *TIMx() { return (TIM_TypeDef *)timx_base; }
+
+  static void Init(uint16_t period, IRQn_Type irqn, uint32_t priority)
+  {
+    TIMx()->CR1 = 0;
+    TIMx()->PSC = 0;
+    TIMx()->ARR = period - 1;
+    TIMx()->CNT = 0;
+    TIMx()->EGR = TIM_EGR_UG;
+    TIMx()->SR = 0;
+    TIMx()->DIER = TIM_DIER_UIE;
+    NVIC_SetPriority(irqn, priority);
+    NVIC_EnableIRQ(irqn);
+    TIMx()->CR1 = TIM_CR1_CEN;
+  }
+
+  static void Stop() { TIMx()->CR1 &= ~TIM_CR1_CEN; }
+
+  template <typename Monitor>
+  static inline void Sample(Monitor &monitor)
+  {
+    const uint32_t count = TIMx()->CNT;
+    TIMx()->SR = ~TIM_SR_UIF;
+    monitor.Push(count);
+  }
+};
+
+#ifndef STM32X_F0XX
+// Blocking character writer for ITM stimulus port, e.g. for CycleHistogram::Dump.
+// Does nothing if ITM or the port isn't enabled by the debugger (SWO).
+template <uint32_t port>
+struct ITMStimulusWriter {
+  static_assert(port < 32);
+
+  static inline bool enabled()
+  {
+    return (ITM->TCR & ITM_TCR_ITMENA_Msk) && (ITM->TER & (1UL << port));
+  }
+
+  static void Write(char c)
+  {
+    if (!enabled()) return;
+    while (!ITM->PORT[port].u32) {}
+    ITM->PORT[port].u8 = static_cast<uint8_t>(c);
+  }
+
+  void operator()(char c) const { Write(c); }
+};
+
+// Non-blocking ITM sink for util::LogBuffer: takes as many chars as the stimulus port accepts
+// without waiting, using 32-bit writes where possible. Data is discarded if ITM isn't enabled so
+// the buffer doesn't fill up without a debugger attached.
+template <uint32_t port>
+struct ITMStimulusSink {
+  static constexpr bool busy() { return false; }
+
+  static size_t Start(const char *data, size_t len)
+  {
+    if (!ITMStimulusWriter<port>::enabled()) return len;
+    size_t n = 0;
+    while (n < len && ITM->PORT[port].u32) {
+      if (len - n >= 4) {
+        uint32_t word;
+        memcpy(&word, data + n, sizeof(word));
+        ITM->PORT[port].u32 = word;
+        n += 4;
+      } else {
+        ITM->PORT[port].u8 = static_cast<uint8_t>(data[n++]);
+      }
+    }
+    return n;
+  }
+};
+
+// DWT profiling counters for EventCounter
+struct DWTEventSource {
+  static constexpr uint32_t kAllEvents = DWT_CTRL_CPIEVTENA_Msk | DWT_CTRL_EXCEVTENA_Msk |
+                                         DWT_CTRL_SLEEPEVTENA_Msk | DWT_CTRL_LSUEVTENA_Msk |
+                                         DWT_CTRL_FOLDEVTENA_Msk;
+
+  // Requires STM32X_DEBUG_INIT; counters that aren't enabled read as 0
+  static void Enable(uint32_t events = kAllEvents)
+  {
+    DWT->CPICNT = 0;
+    DWT->EXCCNT = 0;
+    DWT->SLEEPCNT = 0;
+    DWT->LSUCNT = 0;
+    DWT->FOLDCNT = 0;
+    DWT->CTRL |= events & kAllEvents;
+  }
+
+  static void Disable(uint32_t events = kAllEvents) { DWT->CTRL &= ~(events & kAllEvents); }
+
+  static inline RawEventCounts Read()
+  {
+    return {DWT->CYCCNT,
+            static_cast<uint8_t>(DWT->CPICNT),
+            static_cast<uint8_t>(DWT->EXCCNT),
+            static_cast<uint8_t>(DWT->SLEEPCNT),
+            static_cast<uint8_t>(DWT->LSUCNT),
+            static_cast<uint8_t>(DWT->FOLDCNT)};
+  }
+};
+
+using DWTEventCounter = EventCounter<DWTEventSource>;
+using ScopedDWTMeasurement = ScopedEventMeasurement<DWTEventSource>;
+
+#endif  // !STM32X_F0XX
+
 }  // namespace stm32x
 
-#endif
 #endif  // STM32X_DEBUG_H_
@@ -0,0 +1,73 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Deferred procedure calls drained from a software interrupt
+//
+// The drain runs in PendSV or in an otherwise unused peripheral IRQ pended by software; both work
+// on M0 and M4. Its priority should be below every ISR that posts, so those return immediately
+// and the calls run once no higher priority work is left.
+//
+//   stm32x::DpcQueue<16> dpc_queue;
+//   STM32X_DPC_HANDLER(PendSV_Handler, dpc_queue);
+//   ...
+//   stm32x::PendSVTrigger::Init(stm32x::kLowestIrqPriority);
+//   dpc_queue.Post([](const uint16_t &value) { ... }, adc_value);
+
+#ifndef STM32X_DPC_H_
+#define STM32X_DPC_H_
+
+#include "stm32x.h"
+#include "stm32x_core.h"
+#include "util/util_dpc_queue.h"
+
+namespace stm32x {
+
+static constexpr uint32_t kLowestIrqPriority = (1U << __NVIC_PRIO_BITS) - 1;
+
+struct PendSVTrigger {
+  static void Init(uint32_t priority) { NVIC_SetPriority(PendSV_IRQn, priority); }
+  static inline void Trigger() { SCB->ICSR = SCB_ICSR_PENDSVSET_Msk; }
+};
+
+// The handler for irqn drains the queue instead of serving its peripheral
+template <IRQn_Type irqn>
+struct IrqTrigger {
+  static void Init(uint32_t priority)
+  {
+    NVIC_SetPriority(irqn, priority);
+    NVIC_EnableIRQ(irqn);
+  }
+  static inline void Trigger() { NVIC_SetPendingIRQ(irqn); }
+};
+
+template <size_t size, typename Trigger = PendSVTrigger, size_t payload_size = 8>
+using DpcQueue = util::DpcQueue<size, Trigger, payload_size, ScopedIrqLock>;
+
+}  // namespace stm32x
+
+#define STM32X_DPC_HANDLER(handler, dpc_queue) \
+  extern "C" void handler() { dpc_queue.Drain(); }
+
+#endif  // STM32X_DPC_H_
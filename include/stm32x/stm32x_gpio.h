@@ -131,6 +131,14 @@ struct GPIO {
   static constexpr uint16_t Source = pin;
   static constexpr uint16_t Pin = pin;
 
+  // Configuration, e.g. for InitPins
+  static constexpr GPIO_MODE Mode = mode;
+  static constexpr GPIO_SPEED Speed = speed;
+  static constexpr GPIO_OTYPE OType = otype;
+  static constexpr GPIO_PUPD PuPd = pupd;
+  static constexpr uint8_t AF = af;
+  static constexpr bool EnablePortClock = enable_port_clock;
+
   static inline void Set() { PORT::Set(Mask); }
   static inline void Reset() { PORT::Reset(Mask); }
   static inline bool Read() { return PORT::Read(Mask); }
@@ -27,7 +27,9 @@
 #define STM32X_GPIO_UTIL_H_
 
 #include <cinttypes>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace stm32x {
 
@@ -56,12 +58,109 @@ constexpr uint16_t PinMask()
   return (Pins::Mask | ...);
 }
 
+// Register values for all pins of one port, so each configuration register is written once
+// instead of a GPIO_Init (a loop over all 16 pins with read-modify-writes) per pin. Matches
+// GPIO_Init/GPIO_PinAFConfig: speed and output type only apply to output and AF pins, the AF
+// only to AF pins.
+struct PortInit {
+  static constexpr uint32_t kModerOutput = 0x1;
+  static constexpr uint32_t kModerAlternate = 0x2;
+
+  bool enable_clock = false;
+  uint32_t moder_mask = 0, moder = 0;
+  uint32_t otyper_mask = 0, otyper = 0;
+  uint32_t ospeedr_mask = 0, ospeedr = 0;
+  uint32_t pupdr_mask = 0, pupdr = 0;
+  uint32_t afr_mask[2] = {0, 0}, afr[2] = {0, 0};
+
+  template <typename Pin>
+  constexpr void Add()
+  {
+    const uint32_t pin = Pin::Pin;
+    const uint32_t mode = static_cast<uint32_t>(Pin::Mode);
+    enable_clock |= Pin::EnablePortClock;
+    moder_mask |= 0x3U << (pin * 2);
+    moder |= mode << (pin * 2);
+    pupdr_mask |= 0x3U << (pin * 2);
+    pupdr |= static_cast<uint32_t>(Pin::PuPd) << (pin * 2);
+    if (kModerOutput == mode || kModerAlternate == mode) {
+      otyper_mask |= 0x1U << pin;
+      otyper |= static_cast<uint32_t>(Pin::OType) << pin;
+      ospeedr_mask |= 0x3U << (pin * 2);
+      ospeedr |= static_cast<uint32_t>(Pin::Speed) << (pin * 2);
+    }
+    if (kModerAlternate == mode) {
+      afr_mask[pin >> 3] |= 0xfU << ((pin & 0x7) * 4);
+      afr[pin >> 3] |= static_cast<uint32_t>(Pin::AF) << ((pin & 0x7) * 4);
+    }
+  }
+
+  // The AF and output settings are in place before MODER switches the pins over
+  template <typename Regs>
+  void Apply(Regs *regs) const
+  {
+    for (int i = 0; i < 2; ++i)
+      if (afr_mask[i]) regs->AFR[i] = (regs->AFR[i] & ~afr_mask[i]) | afr[i];
+    if (otyper_mask) regs->OTYPER = (regs->OTYPER & ~otyper_mask) | otyper;
+    if (ospeedr_mask) regs->OSPEEDR = (regs->OSPEEDR & ~ospeedr_mask) | ospeedr;
+    regs->PUPDR = (regs->PUPDR & ~pupdr_mask) | pupdr;
+    regs->MODER = (regs->MODER & ~moder_mask) | moder;
+  }
+};
+
+template <typename Port, typename... Pins>
+constexpr PortInit MakePortInit()
+{
+  PortInit init;
+  ((std::is_same_v<Port, typename Pins::PORT> ? init.Add<Pins>() : void()), ...);
+  return init;
+}
+
+namespace detail {
+template <size_t index, typename... Pins>
+constexpr bool first_pin_of_port()
+{
+  using Port = typename std::tuple_element_t<index, std::tuple<Pins...>>::PORT;
+  constexpr bool same[] = {std::is_same_v<Port, typename Pins::PORT>...};
+  for (size_t i = 0; i < index; ++i)
+    if (same[i]) return false;
+  return true;
+}
+
+template <size_t index, typename... Pins>
+inline void InitPort()
+{
+  if constexpr (first_pin_of_port<index, Pins...>()) {
+    using Port = typename std::tuple_element_t<index, std::tuple<Pins...>>::PORT;
+    static constexpr PortInit init = MakePortInit<Port, Pins...>();
+    if (init.enable_clock) Port::EnableClock(true);
+    init.Apply(Port::regs());
+  }
+}
+
+template <typename... Pins, size_t... indices>
+inline void InitPins(std::index_sequence<indices...>)
+{
+  (InitPort<indices, Pins...>(), ...);
+}
+}  // namespace detail
+
+// Board init: same result as Init<Pins...>() but the pins are grouped by port at compile time and
+// each port's registers are written once.
+template <typename... Pins>
+inline void InitPins()
+{
+  detail::InitPins<Pins...>(std::index_sequence_for<Pins...>{});
+}
+
 template <typename Pin, typename... Pins>
 struct same_port
     : public std::bool_constant<(std::is_same_v<typename Pin::PORT, typename Pins::PORT> && ...)> {
 };
 
-// TODO Ordering? We're assuming all pins are adjacent for set.
+// Pins of a port that are written together, bit i of the value goes to the i-th pin. Pins don't
+// need to be adjacent or in order; the scatter is done with compile-time pin positions (a single
+// shift if they are adjacent and ascending) and the whole group is written with one BSRR store.
 template <typename Pin, typename... Pins>
 struct PinGroup {
   static_assert(same_port<Pin, Pins...>::value);
@@ -69,16 +168,53 @@ struct PinGroup {
 
   static constexpr uint16_t SHIFT = Pin::Pin;
   static constexpr uint16_t MASK = stm32x::PinMask<Pin, Pins...>();
+  static constexpr unsigned WIDTH = 1 + sizeof...(Pins);
+  static constexpr uint16_t PINS[WIDTH] = {Pin::Pin, Pins::Pin...};
+
+  static constexpr bool ADJACENT = [] {
+    for (unsigned i = 1; i < WIDTH; ++i)
+      if (PINS[i] != PINS[0] + i) return false;
+    return true;
+  }();
+  static_assert(
+      [] {
+        unsigned count = 0;
+        for (uint16_t mask = MASK; mask; mask &= mask - 1) ++count;
+        return count == WIDTH;
+      }(),
+      "Duplicate pins in group");
 
-  static void Init() { stm32x::Init<Pin, Pins...>(); }
+  static void Init() { stm32x::InitPins<Pin, Pins...>(); }
 
   static void Reset() { PORT::Reset(MASK); }
 
+  // Pin mask for bits
+  template <typename T>
+  static constexpr uint32_t Scatter(T bits)
+  {
+    const uint32_t value = static_cast<uint32_t>(bits);
+    if constexpr (ADJACENT) {
+      return (value << SHIFT) & MASK;
+    } else {
+      uint32_t set = 0;
+      for (unsigned i = 0; i < WIDTH; ++i) set |= ((value >> i) & 1U) << PINS[i];
+      return set;
+    }
+  }
+
+  // BSRR value that sets the group to bits, i.e. sets the 1s and resets the 0s
+  template <typename T>
+  static constexpr uint32_t BSRR(T bits)
+  {
+    const uint32_t set = Scatter(bits);
+    return set | ((MASK & ~set) << 16);
+  }
+
+  // All pins change with the same write, so there are no intermediate values
   template <typename T>
   static void Set(T bits)
   {
-    PORT::Reset(MASK);
-    PORT::Set((bits << SHIFT) & MASK);
+    PORT::SetReset(BSRR(bits));
   }
 };
 #endif
@@ -33,9 +33,14 @@ static inline uint32_t multiply_u32xu32_rshift32(uint32_t a, uint32_t b)
     __attribute__((always_inline));
 static inline uint32_t multiply_u32xu32_rshift32(uint32_t a, uint32_t b)
 {
+#if defined(__ARM_ARCH_6M__)
+  // No umull on M0
+  return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) >> 32);
+#else
   uint32_t out, tmp;
   asm volatile("umull %0, %1, %2, %3" : "=r"(tmp), "=r"(out) : "r"(a), "r"(b));
   return out;
+#endif
 }
 
 }  // namespace stm32x
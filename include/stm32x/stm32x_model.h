@@ -25,6 +25,8 @@
 #ifndef STM32X_MODEL_H_
 #define STM32X_MODEL_H_
 
+#include <cstddef>
+
 namespace stm32x {
 
 #if defined STM32X_F0XX || defined STM32X_F37X
@@ -42,12 +44,20 @@ static constexpr uint32_t RCC_PERIPH_MASK_GPIOF = RCC_AHBPeriph_GPIOF;
 
 template <typename base>
 struct GPIOxImpl {
+  static inline GPIO_TypeDef *regs() ALWAYS_INLINE { return (GPIO_TypeDef *)base::REGS; }
+
   static inline void Set(uint16_t mask) ALWAYS_INLINE { ((GPIO_TypeDef *)base::REGS)->BSRR = mask; }
   static inline void Reset(uint16_t mask) ALWAYS_INLINE
   {
     ((GPIO_TypeDef *)base::REGS)->BRR = mask;
   }
 
+  // Combined set (low half) and reset (high half) in a single write
+  static inline void SetReset(uint32_t bsrr) ALWAYS_INLINE
+  {
+    ((GPIO_TypeDef *)base::REGS)->BSRR = bsrr;
+  }
+
   static inline bool Read(uint16_t mask) ALWAYS_INLINE
   {
     return ((GPIO_TypeDef *)base::REGS)->IDR & mask;
@@ -102,6 +112,8 @@ static constexpr uint32_t RCC_PERIPH_MASK_GPIOF = RCC_AHB1Periph_GPIOF;
 
 template <typename base>
 struct GPIOxImpl {
+  static inline GPIO_TypeDef *regs() ALWAYS_INLINE { return (GPIO_TypeDef *)base::REGS; }
+
   static inline void Set(uint16_t mask) ALWAYS_INLINE
   {
     ((GPIO_TypeDef *)base::REGS)->BSRRL = mask;
@@ -111,6 +123,13 @@ struct GPIOxImpl {
     ((GPIO_TypeDef *)base::REGS)->BSRRH = mask;
   }
 
+  // Combined set (low half) and reset (high half) in a single write; the StdPeriph headers split
+  // BSRR into two 16-bit halves.
+  static inline void SetReset(uint32_t bsrr) ALWAYS_INLINE
+  {
+    *reinterpret_cast<volatile uint32_t *>(base::REGS + offsetof(GPIO_TypeDef, BSRRL)) = bsrr;
+  }
+
   static inline bool Read(uint16_t mask) ALWAYS_INLINE
   {
     return ((GPIO_TypeDef *)base::REGS)->IDR & mask;
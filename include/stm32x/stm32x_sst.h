@@ -0,0 +1,90 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Run-to-completion tasks on NVIC vectors (see util/util_sst.h)
+//
+// Each task uses an interrupt that is otherwise unused and whose handler only calls Run(). The
+// task priority is the NVIC priority; the main loop is the idle task.
+//
+//   void Control(const ControlEvent &event);
+//   stm32x::SstTaskIrq<ControlEvent, 8, TIM7_IRQn> control_task{Control};
+//   STM32X_SST_TASK_HANDLER(TIM7_IRQHandler, control_task);
+//   ...
+//   control_task.Init(2);
+//   control_task.Post(ControlEvent{...});
+
+#ifndef STM32X_SST_H_
+#define STM32X_SST_H_
+
+#include "stm32x.h"
+#include "stm32x_core.h"
+#include "stm32x_dpc.h"
+#include "util/util_sst.h"
+
+namespace stm32x {
+
+// Priority ceiling mutex: for the lifetime of the object only tasks (and ISRs) with a higher
+// priority than ceiling can run, so the ceiling should be the highest priority (lowest value) of
+// the tasks sharing the resource. Nests, since BASEPRI is only ever raised. M0 has no BASEPRI and
+// masks all interrupts instead.
+template <uint32_t ceiling>
+class PriorityCeilingLock {
+public:
+  DELETE_COPY_MOVE(PriorityCeilingLock);
+
+#if defined STM32X_F0XX
+  PriorityCeilingLock() = default;
+
+private:
+  ScopedIrqLock lock_;
+#else
+  // BASEPRI = 0 doesn't mask anything, so priority 0 would need a ScopedIrqLock
+  static_assert(ceiling > 0 && ceiling <= kLowestIrqPriority);
+
+  PriorityCeilingLock() : basepri_(__get_BASEPRI())
+  {
+    __set_BASEPRI_MAX(ceiling << (8U - __NVIC_PRIO_BITS));
+  }
+  ~PriorityCeilingLock() { __set_BASEPRI(basepri_); }
+
+private:
+  const uint32_t basepri_;
+#endif
+};
+
+template <typename Event, size_t queue_size, IRQn_Type irqn, typename Lock = ScopedIrqLock>
+class SstTaskIrq : public SstTask<Event, queue_size, IrqTrigger<irqn>, Lock> {
+public:
+  using SstTask<Event, queue_size, IrqTrigger<irqn>, Lock>::SstTask;
+
+  void Init(uint32_t priority) { IrqTrigger<irqn>::Init(priority); }
+};
+
+}  // namespace stm32x
+
+#define STM32X_SST_TASK_HANDLER(handler, task) \
+  extern "C" void handler() { task.Run(); }
+
+#endif  // STM32X_SST_H_
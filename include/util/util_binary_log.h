@@ -0,0 +1,113 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Deferred binary logging
+//
+// STM32X_LOG(log, "fmt", args...) doesn't format anything on the target: the format string is
+// placed in the .stm32x_log section, which the linker scripts don't load and locate at address 0,
+// so its address is a unique ID that costs nothing in flash. A record is one header word
+// (ID << 8 | argument count) followed by one word per argument, written into a LogBuffer as a
+// whole or not at all.
+//
+// Arguments are stored as 32-bit words: integers (and enums) are truncated, floating point values
+// stored as float bits, pointers as addresses (%s strings are read from the ELF, so they must be
+// in flash). tools/log_decoder.py reconstructs the messages from the ELF and the captured bytes.
+
+#ifndef STM32X_UTIL_BINARY_LOG_H_
+#define STM32X_UTIL_BINARY_LOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+#include "util/util_log_buffer.h"
+#include "util/util_macros.h"
+
+namespace util {
+
+template <size_t size, typename Sink, typename Lock = NoLock>
+class BinaryLog {
+public:
+  static constexpr size_t kMaxArgs = 255;
+
+  BinaryLog() = default;
+  DELETE_COPY_MOVE(BinaryLog);
+
+  // Use STM32X_LOG; the format literal is only used to check it's a literal
+  template <size_t N, typename... Args>
+  void Log(const char *format_id, const char (&)[N], Args... args)
+  {
+    static_assert(sizeof...(Args) <= kMaxArgs, "Too many log arguments");
+    const uint32_t record[] = {header(format_id, sizeof...(Args)), Encode(args)...};
+    buffer_.Write(reinterpret_cast<const char *>(record), sizeof(record));
+  }
+
+  void Drain() { buffer_.Drain(); }
+
+  inline size_t readable() const { return buffer_.readable(); }
+  inline size_t dropped() const { return buffer_.dropped(); }  // In bytes
+
+  void ResetDropped() { buffer_.ResetDropped(); }
+
+  static inline uint32_t header(const char *format_id, size_t num_args)
+  {
+    return (static_cast<uint32_t>(reinterpret_cast<uintptr_t>(format_id)) << 8) | num_args;
+  }
+
+  template <typename T>
+  static inline uint32_t Encode(T value)
+  {
+    if constexpr (std::is_floating_point_v<T>) {
+      const float f = value;
+      uint32_t bits;
+      memcpy(&bits, &f, sizeof(bits));
+      return bits;
+    } else if constexpr (std::is_pointer_v<T>) {
+      return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(value));
+    } else {
+      static_assert(sizeof(T) <= sizeof(uint32_t), "64-bit log arguments not supported");
+      return static_cast<uint32_t>(value);
+    }
+  }
+
+private:
+  LogBuffer<size, Sink, LOG_OVERFLOW::DROP, Lock> buffer_;
+};
+
+}  // namespace util
+
+#define STM32X_LOG_FORMAT_LITERAL(format, ...) format
+
+// STM32X_LOG(log, format, args...)
+#define STM32X_LOG(log, ...)                                                              \
+  do {                                                                                    \
+    __attribute__((section(".stm32x_log"), used)) static const char stm32x_log_format[] = \
+        STM32X_LOG_FORMAT_LITERAL(__VA_ARGS__, 0);                                        \
+    (log).Log(stm32x_log_format, __VA_ARGS__);                                            \
+  } while (0)
+
+#endif  // STM32X_UTIL_BINARY_LOG_H_
@@ -0,0 +1,323 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Coroutines for peripheral sequencing (requires STM32X_CPPSTD=c++20)
+//
+// CoTask<frames> is an eagerly started coroutine whose frame comes from a static allocator (e.g.
+// FrameSlab, or PoolFrames for a MemoryPool) instead of the heap; if the allocator is exhausted
+// the task is !valid() and never runs. Tasks can co_await other tasks.
+//
+// Coroutines are only resumed from one context, the main loop:
+//   CoExecutor::Run()    resumes coroutines waiting for a CoSignal that was Set() (e.g. in an ISR)
+//   TimerWheel::Dispatch resumes coroutines waiting for CoDelay or CoWaitUntil (polled condition)
+//
+// A task must not be destroyed while it waits for a CoSignal.
+
+#ifndef STM32X_UTIL_COROUTINE_H_
+#define STM32X_UTIL_COROUTINE_H_
+
+#if __cpp_impl_coroutine
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+
+#include "util/util_macros.h"
+#include "util/util_ringbuffer.h"
+#include "util/util_templates.h"
+#include "util/util_timer_wheel.h"
+
+namespace stm32x {
+
+// Fixed size frames with a free list
+template <size_t frame_size, size_t count>
+class FrameSlab {
+public:
+  FrameSlab()
+  {
+    for (auto &block : blocks_) {
+      block.next = free_;
+      free_ = &block;
+    }
+  }
+  DELETE_COPY_MOVE(FrameSlab);
+
+  void *Allocate(size_t size)
+  {
+    if (size > frame_size || !free_) return nullptr;
+    Block *block = free_;
+    free_ = block->next;
+    --available_;
+    return block;
+  }
+
+  void Free(void *p, size_t)
+  {
+    Block *block = static_cast<Block *>(p);
+    block->next = free_;
+    free_ = block;
+    ++available_;
+  }
+
+  size_t available() const { return available_; }
+
+private:
+  union Block {
+    Block *next;
+    alignas(std::max_align_t) uint8_t storage[frame_size];
+  };
+
+  std::array<Block, count> blocks_;
+  Block *free_ = nullptr;
+  size_t available_ = count;
+};
+
+// Frames from a MemoryPool are never freed, e.g. for tasks that run forever
+template <typename Pool>
+class PoolFrames {
+public:
+  explicit PoolFrames(Pool &memory_pool) : pool_(memory_pool) {}
+  DELETE_COPY_MOVE(PoolFrames);
+
+  void *Allocate(size_t size) { return pool_.Alloc(size, alignof(std::max_align_t)); }
+  void Free(void *, size_t) {}
+
+private:
+  Pool &pool_;
+};
+
+template <auto &frames>
+class CoTask {
+public:
+  struct promise_type;
+  using handle_type = std::coroutine_handle<promise_type>;
+
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(handle_type handle) noexcept
+    {
+      auto continuation = handle.promise().continuation;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+
+  struct promise_type {
+    std::coroutine_handle<> continuation;
+
+    static void *operator new(size_t size) noexcept { return frames.Allocate(size); }
+    static void operator delete(void *p, size_t size) { frames.Free(p, size); }
+    static CoTask get_return_object_on_allocation_failure() { return CoTask{}; }
+
+    CoTask get_return_object() { return CoTask{handle_type::from_promise(*this)}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  CoTask() = default;
+  CoTask(CoTask &&other) : handle_(other.handle_) { other.handle_ = nullptr; }
+  CoTask &operator=(CoTask &&other)
+  {
+    if (this != &other) {
+      Destroy();
+      handle_ = other.handle_;
+      other.handle_ = nullptr;
+    }
+    return *this;
+  }
+  ~CoTask() { Destroy(); }
+  DELETE_COPY_ASSIGN(CoTask);
+
+  bool valid() const { return static_cast<bool>(handle_); }
+  bool done() const { return !handle_ || handle_.done(); }
+
+  // Awaiting a task continues when it completes
+  bool await_ready() const { return done(); }
+  void await_suspend(std::coroutine_handle<> handle) { handle_.promise().continuation = handle; }
+  void await_resume() const {}
+
+private:
+  handle_type handle_;
+
+  explicit CoTask(handle_type handle) : handle_(handle) {}
+
+  void Destroy()
+  {
+    if (handle_) handle_.destroy();
+    handle_ = nullptr;
+  }
+};
+
+// Queue of coroutines to resume, filled from ISRs (with Lock) and run from the main loop
+template <size_t size, typename Lock = util::NoLock>
+class CoExecutor {
+public:
+  CoExecutor() = default;
+  DELETE_COPY_MOVE(CoExecutor);
+
+  // Returns false if the queue is full; size it for the number of waiting coroutines
+  bool Schedule(std::coroutine_handle<> handle)
+  {
+    [[maybe_unused]] Lock lock;
+    if (!queue_.writeable()) return false;
+    queue_.Write(handle.address());
+    return true;
+  }
+
+  size_t Run()
+  {
+    size_t count = 0;
+    while (queue_.readable()) {
+      std::coroutine_handle<>::from_address(queue_.Read()).resume();
+      ++count;
+    }
+    return count;
+  }
+
+private:
+  util::RingBuffer<void *, size> queue_;
+};
+
+// Event with a single waiter, e.g. "DMA complete". Set() before the wait isn't lost. A second
+// concurrent waiter is rejected: it doesn't suspend and co_await returns false.
+template <typename Executor, typename Lock = util::NoLock>
+class CoSignal {
+public:
+  explicit CoSignal(Executor &scheduler) : executor_(scheduler) {}
+  DELETE_COPY_MOVE(CoSignal);
+
+  // Returns false if the waiter couldn't be scheduled because the executor is full; it keeps
+  // waiting, the signal stays set and the next Set() retries.
+  bool Set()
+  {
+    [[maybe_unused]] Lock lock;
+    set_ = true;
+    if (!waiter_) return true;
+    if (!executor_.Schedule(waiter_)) return false;
+    waiter_ = nullptr;
+    set_ = false;
+    return true;
+  }
+
+  auto operator co_await()
+  {
+    struct Awaiter {
+      CoSignal &signal;
+      bool rejected = false;
+      bool await_ready() const { return false; }
+      bool await_suspend(std::coroutine_handle<> handle)
+      {
+        [[maybe_unused]] Lock lock;
+        if (signal.waiter_) {
+          rejected = true;
+          return false;
+        }
+        if (signal.set_) {
+          signal.set_ = false;
+          return false;
+        }
+        signal.waiter_ = handle;
+        return true;
+      }
+      bool await_resume() const { return !rejected; }
+    };
+    return Awaiter{*this};
+  }
+
+private:
+  Executor &executor_;
+  std::coroutine_handle<> waiter_;
+  bool set_ = false;
+};
+
+// Resume after ticks of the wheel's clock
+template <typename Wheel>
+class CoDelay : public SoftTimer {
+public:
+  CoDelay(Wheel &timer_wheel, uint32_t ticks)
+      : SoftTimer(Resume), wheel_(timer_wheel), ticks_(ticks)
+  {}
+  ~CoDelay() { wheel_.Stop(*this); }
+
+  bool await_ready() const { return !ticks_; }
+  void await_suspend(std::coroutine_handle<> handle)
+  {
+    handle_ = handle;
+    wheel_.Start(*this, ticks_);
+  }
+  void await_resume() const {}
+
+private:
+  Wheel &wheel_;
+  const uint32_t ticks_;
+  std::coroutine_handle<> handle_;
+
+  static void Resume(SoftTimer &timer) { static_cast<CoDelay &>(timer).handle_.resume(); }
+};
+
+// Resume once predicate() is true, polled every poll_ticks; for conditions without an interrupt,
+// e.g. "flash ready"
+template <typename Wheel, typename Predicate>
+class CoWaitUntil : public SoftTimer {
+public:
+  CoWaitUntil(Wheel &timer_wheel, Predicate predicate, uint32_t poll_ticks = 1)
+      : SoftTimer(Poll), wheel_(timer_wheel), predicate_(predicate), poll_ticks_(poll_ticks)
+  {}
+  ~CoWaitUntil() { wheel_.Stop(*this); }
+
+  bool await_ready() { return predicate_(); }
+  void await_suspend(std::coroutine_handle<> handle)
+  {
+    handle_ = handle;
+    wheel_.Start(*this, poll_ticks_, poll_ticks_);
+  }
+  void await_resume() const {}
+
+private:
+  Wheel &wheel_;
+  Predicate predicate_;
+  const uint32_t poll_ticks_;
+  std::coroutine_handle<> handle_;
+
+  static void Poll(SoftTimer &timer)
+  {
+    auto &self = static_cast<CoWaitUntil &>(timer);
+    if (!self.predicate_()) return;
+    self.wheel_.Stop(self);
+    self.handle_.resume();
+  }
+};
+
+}  // namespace stm32x
+
+#endif  // __cpp_impl_coroutine
+
+#endif  // STM32X_UTIL_COROUTINE_H_
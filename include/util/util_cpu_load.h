@@ -0,0 +1,141 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// CPU load accounting
+//
+// The main loop sleeps via Idle() (see stm32x::Idle in stm32x_debug.h, which masks interrupts
+// around WFI so the time of the ISR that wakes the core isn't counted as idle). ISRs can add an
+// IsrScope to also account their time per priority level; time spent in nested, higher priority
+// ISRs is excluded, so the levels add up.
+//
+// The load is evaluated per window, which closes on the first Idle() after it expires; a saturated
+// main loop therefore reports a long window at (nearly) 100%. Values are in per mille.
+
+#ifndef STM32X_UTIL_CPU_LOAD_H_
+#define STM32X_UTIL_CPU_LOAD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "util/util_macros.h"
+#include "util/util_templates.h"
+
+namespace stm32x {
+
+template <typename Clock, size_t levels, typename Lock = util::NoLock>
+class CpuLoad {
+public:
+  explicit constexpr CpuLoad(uint32_t window_cycles) : window_cycles_(window_cycles) {}
+  DELETE_COPY_MOVE(CpuLoad);
+
+  void Init() { window_start_ = Clock::now(); }
+
+  template <typename Sleep>
+  void Idle(Sleep &&sleep)
+  {
+    const uint32_t start = Clock::now();
+    sleep();
+    const uint32_t end = Clock::now();
+    idle_cycles_ += end - start;
+    if (end - window_start_ >= window_cycles_) CloseWindow(end);
+  }
+
+  class IsrScope {
+  public:
+    DELETE_COPY_MOVE(IsrScope);
+
+    IsrScope(CpuLoad &load, size_t level) : cpu_load_(load), level_(level)
+    {
+      [[maybe_unused]] Lock lock;
+      outer_nested_ = cpu_load_.nested_cycles_;
+      cpu_load_.nested_cycles_ = 0;
+      start_ = Clock::now();
+    }
+
+    ~IsrScope()
+    {
+      [[maybe_unused]] Lock lock;
+      const uint32_t elapsed = Clock::now() - start_;
+      const uint32_t exclusive = elapsed - cpu_load_.nested_cycles_;
+      cpu_load_.window_isr_cycles_[level_] += exclusive;
+      cpu_load_.total_isr_cycles_[level_] += exclusive;
+      cpu_load_.nested_cycles_ = outer_nested_ + elapsed;
+    }
+
+  private:
+    CpuLoad &cpu_load_;
+    const size_t level_;
+    uint32_t outer_nested_;
+    uint32_t start_;
+  };
+
+  uint32_t load() const { return load_; }
+  uint32_t isr_load(size_t level) const { return isr_load_[level]; }
+  uint64_t total_isr_cycles(size_t level) const { return total_isr_cycles_[level]; }
+  uint32_t window_length() const { return window_length_; }  // Cycles of last window
+
+private:
+  const uint32_t window_cycles_;
+
+  uint32_t window_start_ = 0;
+  uint32_t idle_cycles_ = 0;
+  uint32_t nested_cycles_ = 0;
+  uint32_t window_isr_cycles_[levels] = {};
+  uint64_t total_isr_cycles_[levels] = {};
+
+  uint32_t window_length_ = 0;
+  uint32_t load_ = 0;
+  uint32_t isr_load_[levels] = {};
+
+  static uint32_t per_mille(uint32_t cycles, uint32_t length)
+  {
+    return static_cast<uint32_t>(static_cast<uint64_t>(cycles) * 1000 / length);
+  }
+
+  void CloseWindow(uint32_t now)
+  {
+    [[maybe_unused]] Lock lock;
+    const uint32_t length = now - window_start_;
+    window_length_ = length;
+    load_ = 1000 - per_mille(idle_cycles_ < length ? idle_cycles_ : length, length);
+    for (size_t l = 0; l < levels; ++l) {
+      isr_load_[l] = per_mille(window_isr_cycles_[l], length);
+      window_isr_cycles_[l] = 0;
+    }
+    idle_cycles_ = 0;
+    window_start_ = now;
+  }
+};
+
+}  // namespace stm32x
+
+// Account the rest of the ISR scope to priority level
+#define STM32X_CPU_LOAD_ISR(cpu_load, level)                             \
+  typename std::remove_reference_t<decltype(cpu_load)>::IsrScope CONCAT( \
+      stm32x_isr_scope_, __LINE__)(cpu_load, level)
+
+#endif  // STM32X_UTIL_CPU_LOAD_H_
@@ -0,0 +1,149 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Latency histogram with log2-spaced buckets, each octave split into 2^sub_bucket_bits linear
+// sub-buckets (so the relative error of a bucket is at most 1/2^sub_bucket_bits).
+// - Push is O(1) and safe to call from a single ISR context; reading and Reset from another
+//   context may miss or double count a sample, which seems acceptable for profiling.
+// - Percentiles return the upper bound of the bucket, i.e. they err on the side of pessimism.
+
+#ifndef STM32X_UTIL_CYCLE_HISTOGRAM_H_
+#define STM32X_UTIL_CYCLE_HISTOGRAM_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+
+#include "util/util_format.h"
+
+namespace stm32x {
+
+template <unsigned sub_bucket_bits = 2>
+class CycleHistogram {
+public:
+  static constexpr unsigned kSubBucketBits = sub_bucket_bits;
+  static constexpr uint32_t kSubBuckets = 1U << sub_bucket_bits;
+  static constexpr size_t kNumBuckets = (32 - kSubBucketBits + 1) << kSubBucketBits;
+
+  static_assert(sub_bucket_bits > 0 && sub_bucket_bits < 8);
+
+  CycleHistogram() = default;
+
+  static constexpr size_t bucket_index(uint32_t value)
+  {
+    if (value < kSubBuckets) return value;
+    const unsigned msb = 31 - __builtin_clz(value);
+    const unsigned shift = msb - kSubBucketBits;
+    return ((shift + 1) << kSubBucketBits) + ((value >> shift) & (kSubBuckets - 1));
+  }
+
+  static constexpr uint32_t bucket_lower_bound(size_t index)
+  {
+    if (index < kSubBuckets) return index;
+    const unsigned shift = (index >> kSubBucketBits) - 1;
+    return static_cast<uint32_t>(kSubBuckets | (index & (kSubBuckets - 1))) << shift;
+  }
+
+  static constexpr uint32_t bucket_upper_bound(size_t index)
+  {
+    if (index < kSubBuckets) return index;
+    const unsigned shift = (index >> kSubBucketBits) - 1;
+    return bucket_lower_bound(index) + ((1U << shift) - 1);
+  }
+
+  void Reset()
+  {
+    buckets_.fill(0);
+    count_ = 0;
+    max_ = 0;
+  }
+
+  void Push(uint32_t cycles)
+  {
+    ++buckets_[bucket_index(cycles)];
+    ++count_;
+    if (cycles > max_) max_ = cycles;
+  }
+
+  uint32_t count() const { return count_; }
+  uint32_t max() const { return max_; }
+  uint32_t bucket(size_t index) const { return buckets_[index]; }
+
+  // Value below which per_mille/1000 of the samples are, e.g. percentile(999) for p99.9
+  uint32_t percentile(uint32_t per_mille) const
+  {
+    const uint32_t count = count_;
+    if (!count) return 0;
+    const uint32_t rank =
+        static_cast<uint32_t>((static_cast<uint64_t>(count) * per_mille + 999) / 1000);
+    uint32_t total = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      total += buckets_[i];
+      if (total >= rank) return std::min(bucket_upper_bound(i), max_);
+    }
+    return max_;
+  }
+
+  uint32_t p50() const { return percentile(500); }
+  uint32_t p99() const { return percentile(990); }
+  uint32_t p999() const { return percentile(999); }
+
+  // Text dump, one line per non-empty bucket (see util_format.h for Writer)
+  template <typename Writer>
+  void Dump(Writer &&writer, const char *name) const
+  {
+    util::WriteString(writer, name);
+    util::WriteString(writer, ": n=");
+    util::WriteUnsigned(writer, count_);
+    util::WriteString(writer, " p50=");
+    util::WriteUnsigned(writer, p50());
+    util::WriteString(writer, " p99=");
+    util::WriteUnsigned(writer, p99());
+    util::WriteString(writer, " p99.9=");
+    util::WriteUnsigned(writer, p999());
+    util::WriteString(writer, " max=");
+    util::WriteUnsigned(writer, max_);
+    writer('\n');
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      if (!buckets_[i]) continue;
+      util::WriteUnsigned(writer, bucket_lower_bound(i));
+      writer('-');
+      util::WriteUnsigned(writer, bucket_upper_bound(i));
+      writer(' ');
+      util::WriteUnsigned(writer, buckets_[i]);
+      writer('\n');
+    }
+  }
+
+private:
+  std::array<uint32_t, kNumBuckets> buckets_ = {};
+  uint32_t count_ = 0;
+  uint32_t max_ = 0;
+};
+
+}  // namespace stm32x
+
+#endif  // STM32X_UTIL_CYCLE_HISTOGRAM_H_
@@ -0,0 +1,129 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Deferred procedure calls
+//
+// ISRs Post() a function with a small by-value payload and return; the queue is drained by a low
+// priority software interrupt (see stm32x_dpc.h) or the main loop. Posting copies one entry into
+// a RingBuffer and pends the drain via Trigger:
+//   static void Trigger();
+//
+// As with LogBuffer, the RingBuffer is single producer/consumer: with a single posting context
+// Lock can be NoLock, with several ISR priorities it's held for the copy (e.g. ScopedIrqLock).
+// A full queue drops the call and counts it.
+
+#ifndef STM32X_UTIL_DPC_QUEUE_H_
+#define STM32X_UTIL_DPC_QUEUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+#include "util/util_macros.h"
+#include "util/util_ringbuffer.h"
+#include "util/util_templates.h"
+
+namespace util {
+
+template <size_t size, typename Trigger, size_t payload_size = 8, typename Lock = NoLock>
+class DpcQueue {
+public:
+  DpcQueue() = default;
+  DELETE_COPY_MOVE(DpcQueue);
+
+  bool Post(void (*function)())
+  {
+    return Enqueue(Dpc{InvokeVoid, function, {}});
+  }
+
+  // T is deduced from the payload only, so captureless lambdas convert
+  template <typename T>
+  bool Post(void (*function)(const std::common_type_t<T> &), const T &payload)
+  {
+    static_assert(sizeof(T) <= payload_size, "Payload too large for queue");
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>);
+    Dpc dpc{Invoke<T>, reinterpret_cast<void (*)()>(function), {}};
+    memcpy(dpc.payload, &payload, sizeof(T));
+    return Enqueue(dpc);
+  }
+
+  // Run all queued calls, including ones posted while draining. Single consumer.
+  size_t Drain()
+  {
+    size_t count = 0;
+    while (queue_.readable()) {
+      const Dpc &dpc = *queue_.read_head();
+      dpc.invoke(dpc.function, dpc.payload);
+      queue_.Consume(1);
+      ++count;
+    }
+    return count;
+  }
+
+  inline size_t readable() const { return queue_.readable(); }
+  inline size_t dropped() const { return dropped_; }
+
+  void ResetDropped() { dropped_ = 0; }
+
+private:
+  struct Dpc {
+    void (*invoke)(void (*)(), const void *);
+    void (*function)();
+    alignas(4) uint8_t payload[payload_size];
+  };
+
+  RingBuffer<Dpc, size> queue_;
+  volatile size_t dropped_ = 0;
+
+  bool Enqueue(const Dpc &dpc)
+  {
+    {
+      [[maybe_unused]] Lock lock;
+      if (!queue_.writeable()) {
+        dropped_ = dropped_ + 1;
+        return false;
+      }
+      queue_.Write(dpc);
+    }
+    Trigger::Trigger();
+    return true;
+  }
+
+  static void InvokeVoid(void (*function)(), const void *) { function(); }
+
+  template <typename T>
+  static void Invoke(void (*function)(), const void *payload)
+  {
+    T value;
+    memcpy(&value, payload, sizeof(T));
+    reinterpret_cast<void (*)(const T &)>(function)(value);
+  }
+};
+
+}  // namespace util
+
+#endif  // STM32X_UTIL_DPC_QUEUE_H_
@@ -0,0 +1,134 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Profiling event counters
+//
+// The M3/M4 DWT has a 32-bit cycle counter plus 8-bit counters for cycles lost to multi-cycle
+// instructions (CPI), exception overhead (EXC), sleep (SLEEP) and load/store (LSU), and for folded
+// instructions (FOLD). EventCounter extends the 8-bit counters by accumulating their deltas mod
+// 256, so Accumulate must be called before any counter advances by 256 or more, i.e. at least
+// every ~256 cycles in the worst case (e.g. once per loop iteration for long regions).
+//
+// Source provides the raw counters (stm32x::DWTEventSource, or a fake for testing):
+//   static RawEventCounts Read();
+
+#ifndef STM32X_UTIL_EVENT_COUNTERS_H_
+#define STM32X_UTIL_EVENT_COUNTERS_H_
+
+#include <stdint.h>
+
+#include "util/util_macros.h"
+
+namespace stm32x {
+
+struct RawEventCounts {
+  uint32_t cycles;
+  uint8_t cpi;
+  uint8_t exc;
+  uint8_t sleep;
+  uint8_t lsu;
+  uint8_t fold;
+};
+
+struct EventCounts {
+  uint32_t cycles = 0;
+  uint32_t cpi = 0;
+  uint32_t exc = 0;
+  uint32_t sleep = 0;
+  uint32_t lsu = 0;
+  uint32_t fold = 0;
+
+  // Instructions executed, as per the DWT documentation
+  uint32_t instructions() const { return cycles - cpi - exc - sleep - lsu + fold; }
+
+  void Reset() { *this = {}; }
+
+  void Push(const EventCounts &counts)
+  {
+    cycles += counts.cycles;
+    cpi += counts.cpi;
+    exc += counts.exc;
+    sleep += counts.sleep;
+    lsu += counts.lsu;
+    fold += counts.fold;
+  }
+};
+
+template <typename Source>
+class EventCounter {
+public:
+  EventCounter() { Start(); }
+  DELETE_COPY_MOVE(EventCounter);
+
+  void Start()
+  {
+    last_ = Source::Read();
+    counts_.Reset();
+  }
+
+  void Accumulate()
+  {
+    const RawEventCounts now = Source::Read();
+    counts_.cycles += now.cycles - last_.cycles;
+    counts_.cpi += static_cast<uint8_t>(now.cpi - last_.cpi);
+    counts_.exc += static_cast<uint8_t>(now.exc - last_.exc);
+    counts_.sleep += static_cast<uint8_t>(now.sleep - last_.sleep);
+    counts_.lsu += static_cast<uint8_t>(now.lsu - last_.lsu);
+    counts_.fold += static_cast<uint8_t>(now.fold - last_.fold);
+    last_ = now;
+  }
+
+  const EventCounts &counts() const { return counts_; }
+
+private:
+  RawEventCounts last_;
+  EventCounts counts_;
+};
+
+// Destination is anything with Push(const EventCounts &), e.g. EventCounts to sum regions
+template <typename Source, typename Destination = EventCounts>
+class ScopedEventMeasurement {
+public:
+  DELETE_COPY_MOVE(ScopedEventMeasurement);
+
+  ScopedEventMeasurement(Destination &dest) : dest_(dest) {}
+
+  ~ScopedEventMeasurement()
+  {
+    counter_.Accumulate();
+    dest_.Push(counter_.counts());
+  }
+
+  // For long regions, see above
+  void Accumulate() { counter_.Accumulate(); }
+
+private:
+  Destination &dest_;
+  EventCounter<Source> counter_;
+};
+
+}  // namespace stm32x
+
+#endif  // STM32X_UTIL_EVENT_COUNTERS_H_
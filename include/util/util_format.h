@@ -0,0 +1,56 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Minimal text formatting for debug output without pulling in printf.
+// Writer is any callable taking a char (e.g. stm32x::ITMStimulusWriter, a UART, a std::string).
+
+#ifndef STM32X_UTIL_FORMAT_H_
+#define STM32X_UTIL_FORMAT_H_
+
+#include <stdint.h>
+
+namespace util {
+
+template <typename Writer>
+void WriteString(Writer &writer, const char *s)
+{
+  while (*s) writer(*s++);
+}
+
+template <typename Writer>
+void WriteUnsigned(Writer &writer, uint32_t value)
+{
+  char buffer[10];
+  char *p = buffer;
+  do {
+    *p++ = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value);
+  while (p != buffer) writer(*--p);
+}
+
+}  // namespace util
+
+#endif  // STM32X_UTIL_FORMAT_H_
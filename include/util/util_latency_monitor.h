@@ -0,0 +1,105 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Interrupt latency and jitter
+//
+// A timer generates an update interrupt at a fixed period and the handler reads the timer counter
+// first thing (see stm32x::LatencyTimer), so the counter value is the time since the interrupt
+// was raised. With the application running its normal load this shows the entry latency
+// including the time the interrupt is blocked by higher priority ISRs or masked sections.
+// The timer period must be longer than the worst case latency, otherwise the counter has wrapped.
+//
+// Latencies are in CPU cycles (cycles_per_tick scales the timer clock) and are optionally also
+// pushed into profiling zone stats, e.g. STM32X_PROFILE_ZONE_STATS(irq_latency).
+
+#ifndef STM32X_UTIL_LATENCY_MONITOR_H_
+#define STM32X_UTIL_LATENCY_MONITOR_H_
+
+#include <stdint.h>
+
+#include "util/util_cycle_histogram.h"
+#include "util/util_format.h"
+#include "util/util_macros.h"
+#include "util/util_profiler.h"
+
+namespace stm32x {
+
+template <unsigned sub_bucket_bits = 2>
+class LatencyMonitor {
+public:
+  explicit constexpr LatencyMonitor(uint32_t cycles_per_tick = 1,
+                                    ProfilingZoneStats *zone_stats = nullptr)
+      : cycles_per_tick_(cycles_per_tick), zone_stats_(zone_stats)
+  {}
+  DELETE_COPY_MOVE(LatencyMonitor);
+
+  void Push(uint32_t timer_count)
+  {
+    const uint32_t latency = timer_count * cycles_per_tick_;
+    histogram_.Push(latency);
+    if (latency < min_) min_ = latency;
+    if (zone_stats_) zone_stats_->Push(latency);
+  }
+
+  void Reset()
+  {
+    histogram_.Reset();
+    min_ = UINT32_MAX;
+  }
+
+  uint32_t count() const { return histogram_.count(); }
+  uint32_t min() const { return count() ? min_ : 0; }
+  uint32_t max() const { return histogram_.max(); }
+
+  // Peak-to-peak and typical (p99) jitter relative to the best case
+  uint32_t jitter() const { return max() - min(); }
+  uint32_t jitter_p99() const { return histogram_.p99() - min(); }
+
+  const CycleHistogram<sub_bucket_bits> &histogram() const { return histogram_; }
+
+  template <typename Writer>
+  void Report(Writer &&writer, const char *name) const
+  {
+    util::WriteString(writer, name);
+    util::WriteString(writer, ": min=");
+    util::WriteUnsigned(writer, min());
+    util::WriteString(writer, " jitter=");
+    util::WriteUnsigned(writer, jitter());
+    util::WriteString(writer, " jitter_p99=");
+    util::WriteUnsigned(writer, jitter_p99());
+    writer('\n');
+    histogram_.Dump(writer, name);
+  }
+
+private:
+  const uint32_t cycles_per_tick_;
+  ProfilingZoneStats *const zone_stats_;
+  uint32_t min_ = UINT32_MAX;
+  CycleHistogram<sub_bucket_bits> histogram_;
+};
+
+}  // namespace stm32x
+
+#endif  // STM32X_UTIL_LATENCY_MONITOR_H_
@@ -0,0 +1,119 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Non-blocking log output
+//
+// LogBuffer is the backend for printf & co. (via _write, see STM32X_LOG_WRITE_BACKEND) or direct
+// writes: producers only copy into a RingBuffer and never wait for the output. If there isn't
+// enough space the data is dropped according to the LOG_OVERFLOW policy and counted.
+// The buffer is drained from idle time by calling Drain(), which hands contiguous chunks to the
+// Sink without copying. A Sink provides
+//   static bool busy();                                   // previous chunk still in use
+//   static size_t Start(const char *data, size_t len);    // returns number of chars taken
+// Synchronous sinks (e.g. stm32x::ITMStimulusSink) are never busy and may take fewer chars than
+// offered; asynchronous sinks (e.g. stm32f0::UartDmaSink) keep using the data until !busy().
+//
+// RingBuffer is single producer/consumer; if Write is called from several contexts (main loop and
+// ISRs) the Lock is held for the duration of the copy, e.g. stm32x::ScopedIrqLock.
+
+#ifndef STM32X_UTIL_LOG_BUFFER_H_
+#define STM32X_UTIL_LOG_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/util_macros.h"
+#include "util/util_ringbuffer.h"
+#include "util/util_templates.h"
+
+namespace util {
+
+enum struct LOG_OVERFLOW : uint8_t {
+  DROP,      // Drop the entire write if it doesn't fit, so lines stay intact
+  TRUNCATE,  // Write as much as fits
+};
+
+template <size_t size, typename Sink, LOG_OVERFLOW overflow = LOG_OVERFLOW::DROP,
+          typename Lock = NoLock>
+class LogBuffer {
+public:
+  LogBuffer() = default;
+  DELETE_COPY_MOVE(LogBuffer);
+
+  // Returns the number of chars written
+  size_t Write(const char *data, size_t len)
+  {
+    [[maybe_unused]] Lock lock;
+    size_t n = buffer_.writeable();
+    if (len <= n) {
+      n = len;
+    } else {
+      if (LOG_OVERFLOW::DROP == overflow) n = 0;
+      dropped_ += len - n;
+    }
+    if (n) buffer_.Write(data, n);
+    return n;
+  }
+
+  // Consumer side, call from idle (or a low priority ISR)
+  void Drain()
+  {
+    if (Sink::busy()) return;
+    buffer_.Consume(in_flight_);
+    in_flight_ = 0;
+
+    const size_t len = buffer_.readable_contiguous();
+    if (!len) return;
+    in_flight_ = Sink::Start(buffer_.read_head(), len);
+    if (!Sink::busy()) {
+      buffer_.Consume(in_flight_);
+      in_flight_ = 0;
+    }
+  }
+
+  inline size_t readable() const { return buffer_.readable(); }
+  inline size_t dropped() const { return dropped_; }
+
+  void ResetDropped() { dropped_ = 0; }
+
+private:
+  RingBuffer<char, size> buffer_;
+  size_t in_flight_ = 0;
+  volatile size_t dropped_ = 0;
+};
+
+}  // namespace util
+
+// Route newlib's _write to a LogBuffer. Always reports the full length as written, since newlib
+// retries short writes (which would block). Use in a single .cc file; the weak _write in
+// misc/templates/syscalls.c is then overridden.
+#define STM32X_LOG_WRITE_BACKEND(log_buffer)                            \
+  extern "C" int _write(int /*file*/, char *data, int len)              \
+  {                                                                     \
+    if (len > 0) log_buffer.Write(data, static_cast<size_t>(len));      \
+    return len;                                                         \
+  }
+
+#endif  // STM32X_UTIL_LOG_BUFFER_H_
@@ -22,12 +22,17 @@
 #ifndef STM32X_UTIL_CONSTEXPR_LUT_H
 #define STM32X_UTIL_CONSTEXPR_LUT_H
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <utility>
 
 // Live dangerously, constexpr tables only work for gcc where powf, sinf et al. are constexpr.
-// In a project one could also generate tables as python resource, but for tests and/or to compile
-// with clang this just wraps things to be const.
+// For clang this just wraps things to be const, which means the tables are generated at startup and
+// end up in RAM. To avoid that, resource_compiler.LookupTableResource can emit the same tables as
+// constexpr initializers (see test/resources/test_lut_resources.py).
 
 #ifdef __clang__
 #define LUT_GENERATOR_CONSTEXPR
@@ -39,39 +44,129 @@
 
 namespace util {
 
+namespace lut {
+
+// Interpolation policies.
+// Each policy declares how many samples it reads before/after the integer index; the table adds
+// exactly that many guard points so read_interpolated never has to check bounds.
+struct Linear {
+  static constexpr size_t kGuardBefore = 0;
+  static constexpr size_t kGuardAfter = 1;
+
+  template <typename T, typename F>
+  static constexpr T interpolate(const T *p, F t)
+  {
+    return p[0] + (p[1] - p[0]) * t;
+  }
+};
+
+// Cubic Hermite with Catmull-Rom tangents, p[-1]..p[2]
+struct Hermite {
+  static constexpr size_t kGuardBefore = 1;
+  static constexpr size_t kGuardAfter = 2;
+
+  template <typename T, typename F>
+  static constexpr T interpolate(const T *p, F t)
+  {
+    const T c1 = F(0.5) * (p[1] - p[-1]);
+    const T c2 = p[-1] - F(2.5) * p[0] + F(2) * p[1] - F(0.5) * p[2];
+    const T c3 = F(0.5) * (p[2] - p[-1]) + F(1.5) * (p[0] - p[1]);
+    return ((c3 * t + c2) * t + c1) * t + p[0];
+  }
+};
+
+// 4-point, 3rd order Lagrange, p[-1]..p[2]
+struct Lagrange {
+  static constexpr size_t kGuardBefore = 1;
+  static constexpr size_t kGuardAfter = 2;
+
+  template <typename T, typename F>
+  static constexpr T interpolate(const T *p, F t)
+  {
+    const T c1 = p[1] - p[-1] / F(3) - F(0.5) * p[0] - p[2] / F(6);
+    const T c2 = F(0.5) * (p[-1] + p[1]) - p[0];
+    const T c3 = (p[2] - p[-1]) / F(6) + F(0.5) * (p[0] - p[1]);
+    return ((c3 * t + c2) * t + c1) * t + p[0];
+  }
+};
+
+// Boundary modes.
+// index() maps the normalized read index into [0, 1], sample() determines which sample index the
+// generator is asked for when filling a (guard) point so the generator only ever sees [0, N].
+//
+// Clamp: index is clamped, guard points replicate the edges. The sample at N is the end point of
+// the range (e.g. for curves that are defined on [0, 1]).
+struct Clamp {
+  template <typename F>
+  static constexpr F index(F i)
+  {
+    return std::clamp<F>(i, 0, 1);
+  }
+
+  static constexpr size_t sample(ptrdiff_t i, size_t N)
+  {
+    return static_cast<size_t>(std::clamp<ptrdiff_t>(i, 0, N));
+  }
+};
+
+// Wrap: index is treated as phase, guard points are copied from the other end of the table.
+struct Wrap {
+  template <typename F>
+  static constexpr F index(F i)
+  {
+    F f = i - static_cast<F>(static_cast<int32_t>(i));
+    return f < 0 ? f + 1 : f;
+  }
+
+  static constexpr size_t sample(ptrdiff_t i, size_t N)
+  {
+    const auto n = static_cast<ptrdiff_t>(N);
+    return static_cast<size_t>(((i % n) + n) % n);
+  }
+};
+
+}  // namespace lut
+
 // Trying to generalize LUT generators with templates. "Works for select use cases"
 // and it not very well tested.
 //
+// The generator is called as g(i, N) for each point in the table, including the guard points
+// required by the interpolation policy (see lut::Clamp/lut::Wrap for which i are used).
+//
 // TODO Better type handling, there are still some hidden conversions.
 // TODO Traits instead of a bunch of template parameters?
-// TODO enable_if interpolation
-// TODO Also how to handle a fixed-point version. Perhaps templating the interpolation would help.
-template <typename value_type, size_t N, typename index_type = value_type, size_t table_padding = 0>
+// TODO Fixed-point index for read_interpolated
+template <typename value_type, size_t N, typename index_type = value_type,
+          typename Interpolation = lut::Linear, typename Boundary = lut::Clamp>
 struct LookupTable {
   static constexpr size_t kTableSize = N;
-  static constexpr size_t kArraySize = N + table_padding;
+  static constexpr size_t kGuardBefore = Interpolation::kGuardBefore;
+  static constexpr size_t kGuardAfter = Interpolation::kGuardAfter;
+  static constexpr size_t kArraySize = kGuardBefore + N + kGuardAfter;
+
+  static_assert(N > 0);
 
   constexpr auto size() const { return N; }
 
   std::array<value_type, kArraySize> data_;
 
-  constexpr auto read_interpolated(index_type index) const
+  // index is normalized, i.e. [0, 1) maps to [0, N)
+  constexpr value_type read_interpolated(index_type index) const
   {
     static_assert(std::is_floating_point_v<index_type>);
-    index *= kTableSize;
-    auto i = static_cast<size_t>(index);
-    auto a = data_[i];
-    auto b = data_[i + 1];
-    return a + (b - a) * (index - static_cast<float>(i));
+    index = Boundary::index(index) * kTableSize;
+    auto i = std::min(static_cast<size_t>(index), kTableSize - 1);
+    return Interpolation::interpolate(data_.data() + kGuardBefore + i,
+                                      index - static_cast<index_type>(i));
   }
 
   constexpr auto read(index_type index) const
   {
-    index = std::clamp<index_type>(index, 0, kArraySize);
-    return data_[index];
+    index = std::clamp<index_type>(index, 0, kTableSize - 1);
+    return data_[static_cast<size_t>(index) + kGuardBefore];
   }
 
-  constexpr auto operator[](size_t index) const { return data_[index]; }
+  constexpr auto operator[](size_t index) const { return data_[index + kGuardBefore]; }
 
   template <typename G>
   static constexpr LookupTable generate(G g)
@@ -82,7 +177,88 @@ struct LookupTable {
   template <typename G, size_t... Is>
   static constexpr auto table_generator(G g, std::index_sequence<Is...>)
   {
-    return LookupTable{std::array<value_type, kArraySize>{g(Is, kTableSize)...}};
+    return LookupTable{std::array<value_type, kArraySize>{
+        g(Boundary::sample(static_cast<ptrdiff_t>(Is) - static_cast<ptrdiff_t>(kGuardBefore), N),
+          kTableSize)...}};
+  }
+};
+
+// 2D table with bilinear interpolation, e.g. for waveshaping or calibration surfaces.
+// Stored row-major (X is the fast axis) with one guard column and row, so for a fixed y the
+// samples along x are contiguous.
+//
+// The generator is called as g(x, y, X, Y) for each point; boundary modes are per axis and behave
+// as for LookupTable (e.g. lut::Wrap for the phase of a wavetable, lut::Clamp for morphing).
+template <typename value_type, size_t X, size_t Y, typename index_type = value_type,
+          typename BoundaryX = lut::Clamp, typename BoundaryY = lut::Clamp>
+struct LookupTable2D {
+  static constexpr size_t kSizeX = X;
+  static constexpr size_t kSizeY = Y;
+  static constexpr size_t kStride = X + 1;
+  static constexpr size_t kArraySize = kStride * (Y + 1);
+
+  static_assert(X > 0 && Y > 0);
+
+  std::array<value_type, kArraySize> data_;
+
+  constexpr const value_type *row(size_t y) const { return data_.data() + y * kStride; }
+
+  constexpr auto read(size_t x, size_t y) const
+  {
+    return data_[std::min(y, Y - 1) * kStride + std::min(x, X - 1)];
+  }
+
+  // x, y are normalized, i.e. [0, 1) maps to [0, X) and [0, Y) respectively
+  constexpr value_type read_interpolated(index_type x, index_type y) const
+  {
+    static_assert(std::is_floating_point_v<index_type>);
+    x = BoundaryX::index(x) * kSizeX;
+    y = BoundaryY::index(y) * kSizeY;
+    auto i = std::min(static_cast<size_t>(x), kSizeX - 1);
+    auto j = std::min(static_cast<size_t>(y), kSizeY - 1);
+    auto p = row(j) + i;
+    auto a = lut::Linear::interpolate(p, x - static_cast<index_type>(i));
+    auto b = lut::Linear::interpolate(p + kStride, x - static_cast<index_type>(i));
+    return a + (b - a) * (y - static_cast<index_type>(j));
+  }
+
+  // x, y are unsigned Q0.32, so the index is always in range and effectively wraps. For integer
+  // tables the interpolation uses Q15 fractions and 32-bit intermediates, so value_type is limited
+  // to 16 bits.
+  constexpr value_type read_interpolated_fixed(uint32_t x, uint32_t y) const
+  {
+    const uint64_t px = static_cast<uint64_t>(x) * kSizeX;
+    const uint64_t py = static_cast<uint64_t>(y) * kSizeY;
+    auto p = row(static_cast<size_t>(py >> 32)) + static_cast<size_t>(px >> 32);
+    if constexpr (std::is_integral_v<value_type>) {
+      static_assert(sizeof(value_type) <= 2);
+      const int32_t fx = static_cast<int32_t>((px >> 17) & 0x7fff);
+      const int32_t fy = static_cast<int32_t>((py >> 17) & 0x7fff);
+      const int32_t a = p[0] + (((p[1] - p[0]) * fx) >> 15);
+      const int32_t b = p[kStride] + (((p[kStride + 1] - p[kStride]) * fx) >> 15);
+      return static_cast<value_type>(a + (((b - a) * fy) >> 15));
+    } else {
+      constexpr value_type kScale = 1.f / 4294967296.f;
+      const value_type fx = static_cast<value_type>(static_cast<uint32_t>(px)) * kScale;
+      const value_type fy = static_cast<value_type>(static_cast<uint32_t>(py)) * kScale;
+      auto a = lut::Linear::interpolate(p, fx);
+      auto b = lut::Linear::interpolate(p + kStride, fx);
+      return a + (b - a) * fy;
+    }
+  }
+
+  template <typename G>
+  static constexpr LookupTable2D generate(G g)
+  {
+    return table_generator(g, std::make_index_sequence<kArraySize>());
+  }
+
+  template <typename G, size_t... Is>
+  static constexpr auto table_generator(G g, std::index_sequence<Is...>)
+  {
+    return LookupTable2D{std::array<value_type, kArraySize>{
+        g(BoundaryX::sample(static_cast<ptrdiff_t>(Is % kStride), X),
+          BoundaryY::sample(static_cast<ptrdiff_t>(Is / kStride), Y), kSizeX, kSizeY)...}};
   }
 };
 
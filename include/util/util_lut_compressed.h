@@ -0,0 +1,146 @@
+// Copyright (c) 2024 Patrick Dowling
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// -----------------------------------------------------------------------------
+//
+// Runtime side of the compressed table formats in tools/resource_compiler.py
+// - QuarterWaveTable: random access to a table stored as N/4 + 1 points (QuarterWaveArrayResource)
+// - DeltaVarintReader: sequential decode of zigzag varint deltas (DeltaArrayResource), which can
+//   be expanded into a MemoryPool at boot if random access is required.
+
+#ifndef STM32X_UTIL_LUT_COMPRESSED_H_
+#define STM32X_UTIL_LUT_COMPRESSED_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "util/util_memory_pool.h"
+#include "util/util_templates.h"
+
+namespace util {
+
+template <typename T, size_t N>
+class QuarterWaveTable {
+public:
+  static_assert(N >= 4 && util::has_single_bit(N), "N must be power-of-two");
+  static_assert(std::is_signed_v<T>, "Symmetry requires signed values");
+
+  static constexpr size_t kTableSize = N;
+  static constexpr size_t kQuarter = N / 4;
+  static constexpr size_t kStoredSize = kQuarter + 1;
+
+  explicit constexpr QuarterWaveTable(const T *data) : data_(data) {}
+
+  constexpr auto size() const { return N; }
+
+  // Index wraps around
+  constexpr T operator[](size_t index) const
+  {
+    const size_t quadrant = (index / kQuarter) & 3;
+    const size_t i = index & (kQuarter - 1);
+    const T value = data_[(quadrant & 1) ? kQuarter - i : i];
+    return (quadrant & 2) ? static_cast<T>(-value) : value;
+  }
+
+  // phase is normalized, i.e. [0, 1) maps to [0, N)
+  template <typename F>
+  constexpr F read_interpolated(F phase) const
+  {
+    static_assert(std::is_floating_point_v<F>);
+    phase -= static_cast<F>(static_cast<int32_t>(phase));
+    if (phase < 0) phase += 1;
+    phase *= kTableSize;
+    auto i = static_cast<size_t>(phase);
+    F a = (*this)[i];
+    F b = (*this)[i + 1];
+    return a + (b - a) * (phase - static_cast<F>(i));
+  }
+
+private:
+  const T *data_;
+};
+
+class DeltaVarintReader {
+public:
+  DeltaVarintReader(const uint8_t *src, size_t length) : cursor_(src), end_(src + length) {}
+
+  inline bool available() const { return cursor_ < end_; }
+
+  // False once a truncated or overlong (> 32 bit) varint was read; the value returned by that
+  // Next() call is not a decoded sample and available() is false from then on.
+  inline bool ok() const { return !error_; }
+
+  inline int32_t Next()
+  {
+    uint32_t zigzag = 0;
+    for (unsigned shift = 0; shift < 32 && cursor_ < end_; shift += 7) {
+      const uint8_t byte = *cursor_++;
+      if (shift == 28 && (byte & 0x70)) break;  // Bits beyond 32
+      zigzag |= static_cast<uint32_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        // Unsigned so corrupt deltas wrap instead of overflowing
+        value_ += (zigzag >> 1) ^ (0U - (zigzag & 1));
+        return static_cast<int32_t>(value_);
+      }
+    }
+    error_ = true;
+    cursor_ = end_;
+    return static_cast<int32_t>(value_);
+  }
+
+private:
+  const uint8_t *cursor_;
+  const uint8_t *end_;
+  uint32_t value_ = 0;
+  bool error_ = false;
+};
+
+// Decode up to count values into dst, returns number of values decoded. Decoding stops at the
+// first truncated or corrupt varint.
+template <typename T>
+size_t ExpandDeltaVarint(const uint8_t *src, size_t length, T *dst, size_t count)
+{
+  static_assert(std::is_integral_v<T>);
+  DeltaVarintReader reader{src, length};
+  size_t decoded = 0;
+  while (decoded < count && reader.available()) {
+    const auto value = reader.Next();
+    if (!reader.ok()) break;
+    dst[decoded++] = static_cast<T>(value);
+  }
+  return decoded;
+}
+
+// Expand into a pool buffer (e.g. at boot), returns nullptr if the pool is exhausted or the data
+// is truncated. The pool has no per-allocation free, so the buffer is lost on failure; treat a
+// failure as fatal or Free() the pool.
+template <typename T, size_t pool_size>
+const T *ExpandDeltaVarint(stm32x::MemoryPool<pool_size> &pool, const uint8_t *src, size_t length,
+                           size_t count)
+{
+  T *dst = pool.template AllocArray<T>(count);
+  if (!dst || count != ExpandDeltaVarint(src, length, dst, count)) return nullptr;
+  return dst;
+}
+
+}  // namespace util
+
+#endif  // STM32X_UTIL_LUT_COMPRESSED_H_
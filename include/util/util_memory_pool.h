@@ -46,15 +46,14 @@ public:
 
   static constexpr size_t kBufferSize = buffer_size;
 
-  // TODO aligned alloc
-
-  inline uint8_t *Alloc(size_t requested_size)
+  inline uint8_t *Alloc(size_t requested_size, size_t alignment = 1)
   {
-    if (used_ + requested_size > kBufferSize) {
+    auto padding = -reinterpret_cast<uintptr_t>(&buffer_[used_]) & (alignment - 1);
+    if (used_ + padding + requested_size > kBufferSize) {
       return nullptr;
     } else {
-      uint8_t *p = &buffer_[used_];
-      used_ += requested_size;
+      uint8_t *p = &buffer_[used_ + padding];
+      used_ += padding + requested_size;
       return p;
     }
   }
@@ -62,7 +61,7 @@ public:
   template <typename T>
   inline T *AllocArray(size_t count)
   {
-    return reinterpret_cast<T *>(Alloc(sizeof(T) * count));
+    return static_cast<T *>(static_cast<void *>(Alloc(sizeof(T) * count, alignof(T))));
   }
 
   inline void Free() { used_ = 0; }
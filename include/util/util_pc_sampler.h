@@ -0,0 +1,113 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Statistical PC sampling
+//
+// A periodic timer interrupt pushes the interrupted PC (see STM32X_PC_SAMPLER_HANDLER in
+// stm32x_debug.h) into a histogram of address ranges: bucket i covers
+// [base + (i << shift), base + ((i + 1) << shift)). PCs outside of that range (e.g. code in RAM)
+// are only counted. Sampling stops once a bucket is full so the relative profile stays intact.
+//
+// The object is its own dump format (written via Dump() or gdb's "dump binary value"), which
+// tools/pc_profile.py maps to functions using the ELF symbols.
+
+#ifndef STM32X_UTIL_PC_SAMPLER_H_
+#define STM32X_UTIL_PC_SAMPLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+
+#include "util/util_fourcc.h"
+#include "util/util_macros.h"
+
+namespace stm32x {
+
+template <size_t num_buckets, uint32_t shift, typename count_type = uint16_t>
+class PcSampler {
+public:
+  static constexpr uint32_t kMagic = "PCS1"_4CCV;
+  static constexpr count_type kMaxCount = std::numeric_limits<count_type>::max();
+
+  explicit constexpr PcSampler(uint32_t base) : base_(base) {}
+  DELETE_COPY_MOVE(PcSampler);
+
+  void Push(uint32_t pc)
+  {
+    if (!enabled_) return;
+    ++total_;
+    const uint32_t bucket = (pc - base_) >> shift;
+    if (bucket < num_buckets) {
+      if (++counts_[bucket] == kMaxCount) enabled_ = 0;
+    } else {
+      ++other_;
+    }
+  }
+
+  void Start() { enabled_ = 1; }
+  void Stop() { enabled_ = 0; }
+  bool enabled() const { return enabled_; }
+
+  void Reset()
+  {
+    for (auto &c : counts_) c = 0;
+    total_ = other_ = 0;
+  }
+
+  uint32_t total() const { return total_; }
+  uint32_t other() const { return other_; }
+  count_type count(size_t bucket) const { return counts_[bucket]; }
+  uint32_t bucket_address(size_t bucket) const { return base_ + (bucket << shift); }
+
+  // Dump header sanity check
+  bool valid() const
+  {
+    return kMagic == magic_ && shift == shift_ && num_buckets == num_buckets_ &&
+           sizeof(count_type) == count_size_;
+  }
+
+  template <typename Writer>
+  void Dump(Writer &writer) const
+  {
+    auto bytes = reinterpret_cast<const char *>(this);
+    for (size_t i = 0; i < sizeof(*this); ++i) writer(bytes[i]);
+  }
+
+private:
+  const uint32_t magic_ = kMagic;
+  const uint32_t base_;
+  const uint32_t shift_ = shift;
+  const uint32_t num_buckets_ = num_buckets;
+  const uint32_t count_size_ = sizeof(count_type);
+  volatile uint32_t enabled_ = 1;
+  uint32_t total_ = 0;
+  uint32_t other_ = 0;
+  count_type counts_[num_buckets] = {};
+};
+
+}  // namespace stm32x
+
+#endif  // STM32X_UTIL_PC_SAMPLER_H_
@@ -25,6 +25,10 @@
 #ifndef STM32X_UTIL_PIN_TRACE_
 #define STM32X_UTIL_PIN_TRACE_
 
+#include <stdint.h>
+
+#include "util/util_macros.h"
+
 namespace stm32x {
 
 template <typename gpio_type>
@@ -35,6 +39,46 @@ public:
   ~ScopedPinTrace() { gpio_type::Reset(); }
 };
 
+// Encoded zones on a PinGroup, e.g. 4 pins show which of 15 zones is running (0 = none) on a logic
+// analyzer. Each transition is a single BSRR write. Scopes restore the previous zone on exit so
+// nesting (including interrupts) is decoded correctly; the zone is updated before the pins so an
+// interrupt between the two restores the right value.
+template <typename pin_group>
+class PinZoneTrace {
+public:
+  static_assert(pin_group::WIDTH <= 8);
+  static constexpr uint8_t kMaxZone = (1U << pin_group::WIDTH) - 1;
+
+  static void Init() { Enter(0); }
+  static uint8_t current() { return current_; }
+
+  template <uint8_t zone>
+  class Scope {
+  public:
+    static_assert(zone > 0 && zone <= kMaxZone);
+
+    Scope() : previous_(current_) { Enter(zone); }
+    ~Scope() { Enter(previous_); }
+    DELETE_COPY_MOVE(Scope);
+
+  private:
+    const uint8_t previous_;
+  };
+
+private:
+  static inline volatile uint8_t current_ = 0;
+
+  static inline void Enter(uint8_t zone)
+  {
+    current_ = zone;
+    pin_group::Set(zone);
+  }
+};
+
+// Trace the rest of the current scope as zone in trace (a PinZoneTrace)
+#define STM32X_PIN_ZONE(trace, zone) \
+  trace::Scope<zone> CONCAT(stm32x_pin_zone_, __LINE__)
+
 }  // namespace stm32x
 
 #endif  // STM32X_UTIL_PIN_TRACE_
@@ -0,0 +1,183 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Named profiling zones
+//
+// STM32X_PROFILE_ZONE(name) defines the statistics for a zone and places a descriptor in the
+// .profile_zones section (see linker scripts), so Profiler can find all zones without a central
+// list. Zones are measured with STM32X_PROFILE_SCOPE(name) (stm32x_debug.h) or anything that pushes
+// cycles into the stats.
+//
+// Reporting only depends on a range of zones and a char writer (see util_format.h), so it can be
+// used on the host.
+
+#ifndef STM32X_UTIL_PROFILER_H_
+#define STM32X_UTIL_PROFILER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/util_format.h"
+#include "util/util_macros.h"
+
+namespace stm32x {
+
+// Same smoothing as AveragedCycles, plus a count
+struct ProfilingZoneStats {
+  static constexpr uint32_t kSmoothing = 8;
+
+  uint32_t count = 0;
+  uint32_t last = 0;
+  uint32_t average = 0;
+  uint32_t max = 0;
+
+  void Push(uint32_t cycles)
+  {
+    ++count;
+    last = cycles;
+    average = (average * (kSmoothing - 1) + cycles) / kSmoothing;
+    if (cycles > max) max = cycles;
+  }
+
+  void Reset() { count = last = average = max = 0; }
+};
+
+struct ProfilingZone {
+  const char *name;
+  ProfilingZoneStats *stats;
+};
+
+struct ProfilingZones {
+  const ProfilingZone *begin_;
+  const ProfilingZone *end_;
+
+  constexpr const ProfilingZone *begin() const { return begin_; }
+  constexpr const ProfilingZone *end() const { return end_; }
+  constexpr size_t size() const { return end_ - begin_; }
+};
+
+}  // namespace stm32x
+
+#ifndef STM32X_TESTING
+extern "C" const stm32x::ProfilingZone _sprofile_zones[];
+extern "C" const stm32x::ProfilingZone _eprofile_zones[];
+#endif
+
+namespace stm32x {
+
+class Profiler {
+public:
+#ifndef STM32X_TESTING
+  static constexpr ProfilingZones zones() { return {_sprofile_zones, _eprofile_zones}; }
+#endif
+
+  static void Reset(const ProfilingZones &zones)
+  {
+    for (auto &zone : zones) zone.stats->Reset();
+  }
+
+  // name count last average max
+  template <typename Writer>
+  static void Report(const ProfilingZone &zone, Writer &&writer)
+  {
+    const ProfilingZoneStats stats = *zone.stats;
+    util::WriteString(writer, zone.name);
+    writer(' ');
+    util::WriteUnsigned(writer, stats.count);
+    writer(' ');
+    util::WriteUnsigned(writer, stats.last);
+    writer(' ');
+    util::WriteUnsigned(writer, stats.average);
+    writer(' ');
+    util::WriteUnsigned(writer, stats.max);
+    writer('\n');
+  }
+
+  template <typename Writer>
+  static void Report(const ProfilingZones &zones, Writer &&writer)
+  {
+    for (auto &zone : zones) Report(zone, writer);
+  }
+
+#ifndef STM32X_TESTING
+  static void Reset() { Reset(zones()); }
+
+  template <typename Writer>
+  static void Report(Writer &&writer)
+  {
+    Report(zones(), writer);
+  }
+#endif
+};
+
+// Periodically stream zone statistics, e.g. to an ITM stimulus port.
+// Each Poll writes at most one zone so the cost per call stays small; a report is started every
+// period (in whatever units now is, e.g. STM32X_CORE_NOW() ticks) and is preceded by a
+// "# <now>" line.
+template <typename Writer>
+class ProfilerExporter {
+public:
+  constexpr ProfilerExporter(const ProfilingZones &zones, uint32_t period, Writer writer = Writer{})
+      : zones_(zones), period_(period), writer_(writer), next_(zones.end())
+  {}
+
+  void set_period(uint32_t period) { period_ = period; }
+
+  void Poll(uint32_t now)
+  {
+    if (next_ != zones_.end()) {
+      Profiler::Report(*next_++, writer_);
+    } else if (now - last_report_ >= period_) {
+      last_report_ = now;
+      util::WriteString(writer_, "# ");
+      util::WriteUnsigned(writer_, now);
+      writer_('\n');
+      next_ = zones_.begin();
+    }
+  }
+
+private:
+  const ProfilingZones zones_;
+  uint32_t period_;
+  Writer writer_;
+
+  const ProfilingZone *next_;
+  uint32_t last_report_ = 0;
+};
+
+}  // namespace stm32x
+
+#define STM32X_PROFILE_ZONE_STATS(name) CONCAT(stm32x_profile_zone_stats_, name)
+
+#define STM32X_PROFILE_ZONE(name)                                               \
+  stm32x::ProfilingZoneStats STM32X_PROFILE_ZONE_STATS(name);                   \
+  extern const stm32x::ProfilingZone CONCAT(stm32x_profile_zone_, name);        \
+  __attribute__((section(".profile_zones"), used)) const stm32x::ProfilingZone \
+      CONCAT(stm32x_profile_zone_, name) = {#name, &STM32X_PROFILE_ZONE_STATS(name)}
+
+#define STM32X_PROFILE_ZONE_DECLARE(name) \
+  extern stm32x::ProfilingZoneStats STM32X_PROFILE_ZONE_STATS(name)
+
+#endif  // STM32X_UTIL_PROFILER_H_
@@ -34,6 +34,8 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+
 #include "util/util_macros.h"
 #include "util/util_templates.h"
 
@@ -68,6 +70,28 @@ public:
     write_ptr_ = write_ptr + 1;
   }
 
+  // Bulk write, caller must ensure n <= writeable()
+  inline void Write(const T *src, size_t n)
+  {
+    size_t write_ptr = write_ptr_;
+    const size_t offset = write_ptr & (size - 1);
+    const size_t first = std::min(n, size - offset);
+    std::copy_n(src, first, buffer_ + offset);
+    std::copy_n(src + first, n - first, buffer_);
+    write_ptr_ = write_ptr + n;
+  }
+
+  // Zero-copy reads (e.g. for DMA): the readable items starting at read_head()
+  // that don't wrap around. The consumer calls Consume once it's done with them.
+  inline const T *read_head() const { return &buffer_[read_ptr_ & (size - 1)]; }
+
+  inline size_t readable_contiguous() const
+  {
+    return std::min(readable(), size - (read_ptr_ & (size - 1)));
+  }
+
+  inline void Consume(size_t n) { read_ptr_ = read_ptr_ + n; }
+
   inline void Flush() { write_ptr_ = read_ptr_ = 0; }
 
   template <class... Args>
@@ -0,0 +1,200 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Static cooperative scheduler for periodic tasks
+//
+// Tasks are a constexpr table of TaskDescriptor, so there's no registration at runtime. Dispatch()
+// is called from the main loop and runs every due task in priority order (lower value first, then
+// table order). Releases are at phase + n * period in Clock ticks (e.g. STM32X_CORE_NOW()), so
+// late dispatch doesn't accumulate drift. A task that is still due after running, i.e. missed a
+// whole period, counts an overrun and skips the missed releases.
+//
+// Execution time is measured with CycleClock (e.g. CycleCounter) into ProfilingZoneStats, so the
+// report has the same columns as Profiler plus overruns and max lateness (ticks).
+//
+//   void ReadAdc();
+//   void UpdateUi();
+//   constexpr stm32x::TaskDescriptor kTasks[] = {
+//       {"adc", ReadAdc, 1, 0, 0},
+//       {"ui", UpdateUi, 16, 3, 1},
+//   };
+//   stm32x::TaskScheduler<kTasks> scheduler;  // See stm32x_scheduler.h
+
+#ifndef STM32X_UTIL_SCHEDULER_H_
+#define STM32X_UTIL_SCHEDULER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <iterator>
+
+#include "util/util_format.h"
+#include "util/util_macros.h"
+#include "util/util_profiler.h"
+
+namespace stm32x {
+
+struct TaskDescriptor {
+  const char *name;
+  void (*function)();
+  uint32_t period;
+  uint32_t phase;
+  uint8_t priority;
+};
+
+struct TaskStats {
+  ProfilingZoneStats cycles;
+  uint32_t overruns = 0;
+  uint32_t max_lateness = 0;
+
+  void Reset()
+  {
+    cycles.Reset();
+    overruns = max_lateness = 0;
+  }
+};
+
+template <typename Clock, typename CycleClock, const auto &tasks>
+class Scheduler {
+public:
+  static constexpr size_t kNumTasks = std::size(tasks);
+  static_assert(kNumTasks > 0);
+  static_assert(
+      [] {
+        for (auto &task : tasks)
+          if (!task.function || !task.period) return false;
+        return true;
+      }(),
+      "Tasks require a function and period");
+
+  Scheduler() = default;
+  DELETE_COPY_MOVE(Scheduler);
+
+  void Init()
+  {
+    const uint32_t now = Clock::now();
+    for (size_t i = 0; i < kNumTasks; ++i) {
+      next_release_[i] = now + tasks[i].phase;
+      stats_[i].Reset();
+    }
+  }
+
+  // Run all due tasks, returns the number of tasks run
+  size_t Dispatch()
+  {
+    size_t count = 0;
+    for (;;) {
+      const uint32_t now = Clock::now();
+      const size_t index = NextDue(now);
+      if (index >= kNumTasks) break;
+      Run(index, now);
+      ++count;
+    }
+    return count;
+  }
+
+  // Ticks until the next release (0 if something is due), e.g. to decide whether to sleep
+  uint32_t ticks_until_next() const
+  {
+    const uint32_t now = Clock::now();
+    uint32_t ticks = UINT32_MAX;
+    for (size_t i = 0; i < kNumTasks; ++i) {
+      const int32_t delta = static_cast<int32_t>(next_release_[i] - now);
+      if (delta <= 0) return 0;
+      if (static_cast<uint32_t>(delta) < ticks) ticks = delta;
+    }
+    return ticks;
+  }
+
+  const TaskStats &stats(size_t index) const { return stats_[index]; }
+
+  void ResetStats()
+  {
+    for (auto &stats : stats_) stats.Reset();
+  }
+
+  // One line per task: name count last average max overruns max_lateness
+  template <typename Writer>
+  void Report(Writer &&writer) const
+  {
+    for (size_t i = 0; i < kNumTasks; ++i) {
+      const TaskStats &stats = stats_[i];
+      util::WriteString(writer, tasks[i].name);
+      writer(' ');
+      util::WriteUnsigned(writer, stats.cycles.count);
+      writer(' ');
+      util::WriteUnsigned(writer, stats.cycles.last);
+      writer(' ');
+      util::WriteUnsigned(writer, stats.cycles.average);
+      writer(' ');
+      util::WriteUnsigned(writer, stats.cycles.max);
+      writer(' ');
+      util::WriteUnsigned(writer, stats.overruns);
+      writer(' ');
+      util::WriteUnsigned(writer, stats.max_lateness);
+      writer('\n');
+    }
+  }
+
+private:
+  std::array<uint32_t, kNumTasks> next_release_ = {};
+  std::array<TaskStats, kNumTasks> stats_ = {};
+
+  size_t NextDue(uint32_t now) const
+  {
+    size_t due = kNumTasks;
+    for (size_t i = 0; i < kNumTasks; ++i) {
+      if (static_cast<int32_t>(now - next_release_[i]) < 0) continue;
+      if (due >= kNumTasks || tasks[i].priority < tasks[due].priority) due = i;
+    }
+    return due;
+  }
+
+  void Run(size_t index, uint32_t now)
+  {
+    const TaskDescriptor &task = tasks[index];
+    TaskStats &stats = stats_[index];
+
+    const uint32_t lateness = now - next_release_[index];
+    if (lateness > stats.max_lateness) stats.max_lateness = lateness;
+
+    const uint32_t start = CycleClock::now();
+    task.function();
+    stats.cycles.Push(CycleClock::now() - start);
+
+    uint32_t &next = next_release_[index];
+    next += task.period;
+    const uint32_t end = Clock::now();
+    if (static_cast<int32_t>(end - next) >= 0) {
+      ++stats.overruns;
+      next += ((end - next) / task.period + 1) * task.period;
+    }
+  }
+};
+
+}  // namespace stm32x
+
+#endif  // STM32X_UTIL_SCHEDULER_H_
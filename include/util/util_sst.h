@@ -0,0 +1,96 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Run-to-completion tasks (SST, "super simple tasker")
+//
+// Each task is an event handler bound to an otherwise unused interrupt vector. Post() queues the
+// event and pends the vector; the NVIC then runs the task once nothing of higher priority is
+// active, and preempts it for higher priority tasks. Tasks never block, so all of them share the
+// main stack and there's no context switching beyond exception entry.
+//
+// Trigger is the vector (e.g. stm32x::IrqTrigger), Lock protects the queue if events are posted
+// from several priorities (e.g. ScopedIrqLock, or a PriorityCeilingLock for the highest poster).
+// Shared data between tasks can be protected with a PriorityCeilingLock (see stm32x_sst.h).
+
+#ifndef STM32X_UTIL_SST_H_
+#define STM32X_UTIL_SST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/util_macros.h"
+#include "util/util_ringbuffer.h"
+#include "util/util_templates.h"
+
+namespace stm32x {
+
+template <typename Event, size_t queue_size, typename Trigger, typename Lock = util::NoLock>
+class SstTask {
+public:
+  using Handler = void (*)(const Event &);
+
+  explicit SstTask(Handler handler) : handler_(handler) {}
+  DELETE_COPY_MOVE(SstTask);
+
+  // Returns false if the queue is full, the event is dropped
+  bool Post(const Event &event)
+  {
+    {
+      [[maybe_unused]] Lock lock;
+      const size_t readable = queue_.readable();
+      if (readable >= queue_size) {
+        dropped_ = dropped_ + 1;
+        return false;
+      }
+      queue_.Write(event);
+      if (readable + 1 > max_queued_) max_queued_ = readable + 1;
+    }
+    Trigger::Trigger();
+    return true;
+  }
+
+  // Call from the task's vector; runs each queued event to completion
+  void Run()
+  {
+    while (queue_.readable()) {
+      handler_(*queue_.read_head());
+      queue_.Consume(1);
+    }
+  }
+
+  inline size_t queued() const { return queue_.readable(); }
+  inline size_t dropped() const { return dropped_; }
+  inline size_t max_queued() const { return max_queued_; }
+
+private:
+  const Handler handler_;
+  util::RingBuffer<Event, queue_size> queue_;
+  volatile size_t dropped_ = 0;
+  volatile size_t max_queued_ = 0;
+};
+
+}  // namespace stm32x
+
+#endif  // STM32X_UTIL_SST_H_
@@ -0,0 +1,117 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Stack high-water mark
+//
+// With ENABLE_STACK_PAINT the startup code fills the free stack region with kPattern. StackMonitor
+// finds the lowest word that has been overwritten, scanning a few words per Poll (e.g. from idle).
+// Since the stack only grows downwards each pass only has to check below the previous mark.
+//
+// The region is [_sstack, _estack) in SRAM, or [_sccmstack, _eccmstack) with ENABLE_CCM_STACK
+// (see linker scripts), i.e. all memory the stack can use, not just _Min_Stack_Size.
+
+#ifndef STM32X_UTIL_STACK_MONITOR_H_
+#define STM32X_UTIL_STACK_MONITOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/util_format.h"
+
+#ifndef STM32X_TESTING
+#ifdef ENABLE_CCM_STACK
+extern "C" const uint32_t _sccmstack[];
+extern "C" const uint32_t _eccmstack[];
+#else
+extern "C" const uint32_t _sstack[];
+extern "C" const uint32_t _estack[];
+#endif
+#endif
+
+namespace stm32x {
+
+class StackMonitor {
+public:
+  static constexpr uint32_t kPattern = 0xa5a5a5a5;  // Must match startup code
+
+  constexpr StackMonitor(const volatile uint32_t *bottom, const volatile uint32_t *top)
+      : bottom_(bottom), top_(top), scan_(bottom), mark_(top)
+  {}
+
+#ifndef STM32X_TESTING
+#ifdef ENABLE_CCM_STACK
+  static constexpr StackMonitor MainStack() { return {_sccmstack, _eccmstack}; }
+#else
+  static constexpr StackMonitor MainStack() { return {_sstack, _estack}; }
+#endif
+#endif
+
+  // Check up to `words` words; returns true if a pass is complete
+  bool Poll(size_t words = 8)
+  {
+    while (words--) {
+      if (scan_ >= mark_ || *scan_ != kPattern) {
+        mark_ = scan_;
+        scan_ = bottom_;
+        ++passes_;
+        return true;
+      }
+      ++scan_;
+    }
+    return false;
+  }
+
+  // Sizes in bytes, as of the last complete pass
+  size_t size() const { return (top_ - bottom_) * sizeof(uint32_t); }
+  size_t headroom() const { return (mark_ - bottom_) * sizeof(uint32_t); }
+  size_t used() const { return size() - headroom(); }
+
+  uint32_t passes() const { return passes_; }
+
+  // name size used headroom
+  template <typename Writer>
+  void Report(Writer &&writer, const char *name) const
+  {
+    util::WriteString(writer, name);
+    writer(' ');
+    util::WriteUnsigned(writer, size());
+    writer(' ');
+    util::WriteUnsigned(writer, used());
+    writer(' ');
+    util::WriteUnsigned(writer, headroom());
+    writer('\n');
+  }
+
+private:
+  const volatile uint32_t *const bottom_;
+  const volatile uint32_t *const top_;
+  const volatile uint32_t *scan_;
+  const volatile uint32_t *mark_;
+  uint32_t passes_ = 0;
+};
+
+}  // namespace stm32x
+
+#endif  // STM32X_UTIL_STACK_MONITOR_H_
@@ -60,6 +60,9 @@ constexpr typename std::underlying_type<E>::type enum_count()
   return static_cast<typename std::underlying_type<E>::type>(E::LAST);
 }
 
+// Lock policy for single-context use (the real one is e.g. stm32x::ScopedIrqLock)
+struct NoLock {};
+
 }  // namespace util
 
 #define ENABLE_ENUM_TO_INDEX(enum_type)   \
@@ -0,0 +1,186 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Monotonic timebase from a tick counter and a down-counting reload timer (i.e. SysTick)
+//
+// The tick ISR calls Tick(); the 32-bit tick count is extended to 64 bits with a high word that
+// is only updated on wrap. Sub-tick resolution comes from the timer value. A reload that happens
+// before its tick has been handled is detected with the timer's read-to-clear reload flag, which
+// requires that the tick ISR isn't held off for more than one tick period. Only the timebase may
+// read the flag. Once seen, the reload is remembered until Tick() runs, so it's also counted
+// between entry to the tick ISR and its call to Tick() (the NVIC pending bit is already clear by
+// then), including by ISRs that preempt it there.
+//
+// Timer policy (see stm32x::SysTickTimer):
+//   static constexpr uint32_t kMaxLoad;  // largest reload value - 1, e.g. 24 bits for SysTick
+//   static uint32_t value();             // current count, reload-1 ... 0
+//   static bool reloaded();              // reload since the last call, e.g. COUNTFLAG
+//
+// For tickless idle (see Core::TicklessIdle) the timer is reprogrammed to fire after several ticks
+// and the ticks that passed are added on wake. PlanSleep and CorrectAfterSleep do the math on the
+// stopped timer's values; the cycles it is stopped for are lost, so time drifts by a few cycles per
+// sleep.
+
+#ifndef STM32X_UTIL_TIMEBASE_H_
+#define STM32X_UTIL_TIMEBASE_H_
+
+#include <stdint.h>
+
+#include "util/util_macros.h"
+
+namespace stm32x {
+
+template <typename Timer>
+class Timebase {
+public:
+  Timebase() = default;
+  DELETE_COPY_MOVE(Timebase);
+
+  // Optionally start at an arbitrary tick count, e.g. when restoring time after standby
+  void Init(uint32_t reload, uint32_t cycles_per_us, uint64_t ticks = 0)
+  {
+    ticks_ = static_cast<uint32_t>(ticks);
+    ticks_hi_ = static_cast<uint32_t>(ticks >> 32);
+    reload_tick_ = ticks_;
+    reload_ = reload;
+    cycles_per_us_ = cycles_per_us;
+  }
+
+  // The reload is marked as seen before the flag is cleared, so a read that preempts this still
+  // counts it.
+  void Tick()
+  {
+    reload_tick_ = ticks_ + 1;
+    Timer::reloaded();
+    if (!++ticks_) ++ticks_hi_;
+  }
+
+  inline uint32_t now() const volatile { return ticks_; }
+
+  // Account ticks that passed without Tick(), e.g. during tickless idle
+  void AddTicks(uint32_t ticks)
+  {
+    const uint32_t sum = ticks_ + ticks;
+    if (sum < ticks_) ++ticks_hi_;
+    ticks_ = sum;
+  }
+
+  // The reload flag was consumed elsewhere (e.g. by tickless idle) and the tick ISR is pending
+  void SetReloadPending() { reload_tick_ = ticks_ + 1; }
+
+  // Free-running cycle count, wrapping at 2^32 like DWT->CYCCNT
+  inline uint32_t cycles() const
+  {
+    const auto snapshot = Read();
+    return (snapshot.ticks + snapshot.pending) * reload_ + snapshot.offset;
+  }
+
+  // 64-bit cycle count since Init
+  uint64_t now_cycles() const
+  {
+    const auto snapshot = Read();
+    const uint64_t ticks = (static_cast<uint64_t>(snapshot.ticks_hi) << 32) | snapshot.ticks;
+    return (ticks + snapshot.pending) * reload_ + snapshot.offset;
+  }
+
+  uint64_t now_us() const { return now_cycles() / cycles_per_us_; }
+
+  uint32_t cycles_per_us() const { return cycles_per_us_; }
+  uint32_t reload() const { return reload_; }
+
+  struct SleepPlan {
+    uint32_t ticks;  // Tick boundaries covered if the sleep isn't interrupted
+    uint32_t load;   // Timer load value
+  };
+
+  struct WakeCorrection {
+    uint32_t ticks;  // Completed ticks to add (the pending tick ISR adds the last one if expired)
+    uint32_t load;   // Load value for the rest of the current tick
+  };
+
+  uint32_t max_sleep_ticks() const { return (Timer::kMaxLoad - (reload_ - 1)) / reload_ + 1; }
+
+  // Sleep for idle_ticks tick boundaries, starting with the stopped timer at value
+  SleepPlan PlanSleep(uint32_t idle_ticks, uint32_t value) const
+  {
+    const uint32_t max_ticks = max_sleep_ticks();
+    if (idle_ticks > max_ticks) idle_ticks = max_ticks;
+    if (!idle_ticks) idle_ticks = 1;
+    return {idle_ticks, value + (idle_ticks - 1) * reload_};
+  }
+
+  // After waking with the timer stopped at value; expired if it reached the end of the sleep.
+  // A zero load would stop the timer, so one cycle before a boundary the next tick starts early.
+  WakeCorrection CorrectAfterSleep(const SleepPlan &plan, bool expired, uint32_t value) const
+  {
+    if (expired) {
+      // Reloaded with plan.load at the end of the sleep and counted down since
+      const uint32_t since = plan.load - value;
+      const uint32_t ticks = plan.ticks - 1 + since / reload_;
+      const uint32_t elapsed = since % reload_;
+      if (elapsed == reload_ - 1) return {ticks + 1, reload_ - 1};
+      return {ticks, reload_ - 1 - elapsed};
+    }
+    const uint32_t ticks = plan.ticks - 1 - value / reload_;
+    const uint32_t remaining = value % reload_;
+    if (!remaining) return {ticks + 1, reload_ - 1};
+    return {ticks, remaining};
+  }
+
+private:
+  struct Snapshot {
+    uint32_t ticks_hi;
+    uint32_t ticks;
+    uint32_t pending;
+    uint32_t offset;
+  };
+
+  // Retries if a tick is handled during the read. The high word is read after the low word, so a
+  // wrap in between is caught by the same check.
+  inline Snapshot Read() const
+  {
+    for (;;) {
+      const uint32_t ticks = ticks_;
+      const uint32_t ticks_hi = ticks_hi_;
+      uint32_t value = Timer::value();
+      if (Timer::reloaded()) {
+        reload_tick_ = ticks + 1;
+        value = Timer::value();
+      }
+      const uint32_t pending = reload_tick_ == ticks + 1 ? 1 : 0;
+      if (ticks_ == ticks) return {ticks_hi, ticks, pending, reload_ - 1 - value};
+    }
+  }
+
+  volatile uint32_t ticks_ = 0;
+  volatile uint32_t ticks_hi_ = 0;
+  mutable volatile uint32_t reload_tick_ = 0;  // Tick whose reload was seen, == ticks_ + 1 if due
+  uint32_t reload_ = 1;
+  uint32_t cycles_per_us_ = 1;
+};
+
+}  // namespace stm32x
+
+#endif  // STM32X_UTIL_TIMEBASE_H_
@@ -0,0 +1,217 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+// Hierarchical timer wheel for software timers
+//
+// Timers are intrusive (SoftTimer objects owned by the caller) in doubly-linked slot lists, so
+// Start, Stop and expiry are O(1). Level 0 has one slot per tick; each further level covers
+// 2^slot_bits times the range of the one below and is cascaded down when the lower level wraps.
+// Timeouts beyond the top level are re-evaluated on each top level cascade.
+//
+// The wheel follows Clock (e.g. CoreTicks, so it's driven by Core::Tick()) but nothing happens in
+// the tick ISR: Dispatch() is called from the main loop, catches up with the elapsed ticks and runs
+// the callbacks. Start/Stop must only be called from the same context as Dispatch.
+
+#ifndef STM32X_UTIL_TIMER_WHEEL_H_
+#define STM32X_UTIL_TIMER_WHEEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+
+#include "util/util_macros.h"
+
+namespace stm32x {
+
+template <typename Clock, unsigned slot_bits, unsigned levels>
+class TimerWheel;
+
+struct TimerListNode {
+  TimerListNode *next = nullptr;
+  TimerListNode *prev = nullptr;
+
+  void Reset() { next = prev = this; }
+  bool empty() const { return next == this; }
+
+  void Unlink()
+  {
+    next->prev = prev;
+    prev->next = next;
+    next = prev = nullptr;
+  }
+
+  void Append(TimerListNode *node)
+  {
+    node->prev = prev;
+    node->next = this;
+    prev->next = node;
+    prev = node;
+  }
+};
+
+class SoftTimer : private TimerListNode {
+public:
+  using Callback = void (*)(SoftTimer &);
+
+  explicit SoftTimer(Callback callback) : callback_(callback) {}
+  DELETE_COPY_MOVE(SoftTimer);
+
+  bool active() const { return next != nullptr; }
+  uint32_t expires() const { return expires_; }
+  uint32_t period() const { return period_; }
+
+private:
+  Callback callback_;
+  uint32_t expires_ = 0;
+  uint32_t period_ = 0;
+
+  template <typename, unsigned, unsigned>
+  friend class TimerWheel;
+};
+
+template <typename Clock, unsigned slot_bits = 6, unsigned levels = 4>
+class TimerWheel {
+public:
+  static_assert(slot_bits * levels <= 31);
+  static constexpr uint32_t kSlots = 1U << slot_bits;
+  static constexpr uint32_t kSlotMask = kSlots - 1;
+  static constexpr uint32_t kMaxRange = 1U << (slot_bits * levels);
+
+  TimerWheel() { Init(); }
+  DELETE_COPY_MOVE(TimerWheel);
+
+  // Clears all slots, active timers are lost
+  void Init()
+  {
+    for (auto &slot : slots_) slot.Reset();
+    now_ = Clock::now();
+  }
+
+  // Expire in timeout ticks (at least 1) from now; periodic timers are re-armed with period before
+  // their callback runs, i.e. without drift.
+  void Start(SoftTimer &timer, uint32_t timeout, uint32_t period = 0)
+  {
+    Stop(timer);
+    timer.expires_ = Clock::now() + (timeout ? timeout : 1);
+    timer.period_ = period;
+    Insert(timer);
+  }
+
+  void Stop(SoftTimer &timer)
+  {
+    if (timer.active()) timer.Unlink();
+  }
+
+  // Process elapsed ticks and run callbacks of expired timers, returns the number of callbacks
+  size_t Dispatch()
+  {
+    size_t count = 0;
+    const uint32_t now = Clock::now();
+    while (now_ != now) count += Advance();
+    return count;
+  }
+
+  uint32_t now() const { return now_; }
+
+private:
+  std::array<TimerListNode, kSlots * levels> slots_;
+  uint32_t now_ = 0;
+
+  static constexpr unsigned shift(unsigned level) { return level * slot_bits; }
+
+  TimerListNode &slot(unsigned level, uint32_t time)
+  {
+    return slots_[level * kSlots + ((time >> shift(level)) & kSlotMask)];
+  }
+
+  void Insert(SoftTimer &timer)
+  {
+    uint32_t expires = timer.expires_;
+    uint32_t delta = expires - now_;
+    if (static_cast<int32_t>(delta) < 0) {
+      expires = now_ + 1;
+      delta = 1;
+    } else if (delta >= kMaxRange) {
+      expires = now_ + kMaxRange - 1;
+      delta = kMaxRange - 1;
+    }
+    unsigned level = 0;
+    while (delta >= (1U << shift(level + 1))) ++level;
+    slot(level, expires).Append(&timer);
+  }
+
+  // Re-insert all timers of a slot, which moves them to lower levels
+  void Cascade(unsigned level)
+  {
+    TimerListNode list;
+    Detach(slot(level, now_), list);
+    while (!list.empty()) {
+      SoftTimer &timer = *static_cast<SoftTimer *>(list.next);
+      timer.Unlink();
+      Insert(timer);
+    }
+  }
+
+  size_t Advance()
+  {
+    ++now_;
+    for (unsigned level = 1; level < levels; ++level) {
+      if (now_ & ((1U << shift(level)) - 1)) break;
+      Cascade(level);
+    }
+
+    // Callbacks may start or stop any timer, including ones still in the expired list
+    size_t count = 0;
+    TimerListNode expired;
+    Detach(slot(0, now_), expired);
+    while (!expired.empty()) {
+      SoftTimer &timer = *static_cast<SoftTimer *>(expired.next);
+      timer.Unlink();
+      if (timer.period_) {
+        timer.expires_ += timer.period_;
+        Insert(timer);
+      }
+      timer.callback_(timer);
+      ++count;
+    }
+    return count;
+  }
+
+  static void Detach(TimerListNode &slot, TimerListNode &list)
+  {
+    list.Reset();
+    if (slot.empty()) return;
+    list.next = slot.next;
+    list.prev = slot.prev;
+    list.next->prev = &list;
+    list.prev->next = &list;
+    slot.Reset();
+  }
+};
+
+}  // namespace stm32x
+
+#endif  // STM32X_UTIL_TIMER_WHEEL_H_
@@ -25,10 +25,28 @@
 // -----------------------------------------------------------------------------
 //
 // Stupidly simple tracer
+//
+// EventTrace is the timestamped version: a flight recorder of begin/end/instant/counter events
+// that can be written from any context, including nested ISRs. Each event atomically claims a slot,
+// so the buffer always holds the latest `length` events. Event names are placed in the
+// .stm32x_log section like STM32X_LOG format strings, so an event only stores the offset.
+// The object itself is the dump format (header words followed by the events), written via Dump()
+// or gdb (scripts/gdb_trace_dump.scr); tools/trace_to_chrome.py converts that to Chrome trace JSON.
+//
+// Source provides the timestamp and execution context, e.g. stm32x::CycleTraceSource:
+//   static uint32_t now();
+//   static uint8_t context();  // Active exception number, 0 = thread mode
 
 #ifndef STM32X_UTIL_TRACEBUFFER_H_
 #define STM32X_UTIL_TRACEBUFFER_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/util_fourcc.h"
+#include "util/util_macros.h"
+#include "util/util_templates.h"
+
 namespace util {
 
 template <size_t length>
@@ -50,6 +68,121 @@ private:
   char buffer_[kBufferSize];
 };
 
+enum struct TRACE_EVENT : uint8_t { BEGIN, END, INSTANT, COUNTER };
+
+struct TraceEvent {
+  uint32_t timestamp;
+  uint32_t name;
+  TRACE_EVENT type;
+  uint8_t context;
+  int16_t value;
+};
+static_assert(sizeof(TraceEvent) == 12, "TraceEvent layout is part of the dump format");
+
+template <size_t length, typename Source>
+class EventTrace {
+public:
+  static_assert(util::has_single_bit(length), "length must be power-of-two");
+  static constexpr uint32_t kMagic = "TRC1"_4CCV;
+
+  constexpr EventTrace() = default;
+  DELETE_COPY_MOVE(EventTrace);
+
+  inline void Begin(const char *name) { Record(TRACE_EVENT::BEGIN, name, 0); }
+  inline void End(const char *name) { Record(TRACE_EVENT::END, name, 0); }
+  inline void Instant(const char *name) { Record(TRACE_EVENT::INSTANT, name, 0); }
+  inline void Counter(const char *name, int16_t value)
+  {
+    Record(TRACE_EVENT::COUNTER, name, value);
+  }
+
+  // Stop recording, e.g. before dumping or when an error condition is detected
+  void Stop() { enabled_ = 0; }
+  void Start() { enabled_ = 1; }
+
+  void Reset() { head_ = 0; }
+
+  size_t size() const { return head_ < length ? head_ : length; }
+
+  // Events in order, i = 0 is the oldest
+  const TraceEvent &event(size_t i) const
+  {
+    return events_[(head_ - size() + i) & (length - 1)];
+  }
+
+  // Dump header sanity check
+  bool valid() const { return kMagic == magic_ && length == length_; }
+
+  template <typename Writer>
+  void Dump(Writer &writer) const
+  {
+    auto bytes = reinterpret_cast<const char *>(this);
+    for (size_t i = 0; i < sizeof(*this); ++i) writer(bytes[i]);
+  }
+
+private:
+  const uint32_t magic_ = kMagic;
+  const uint32_t length_ = length;
+  uint32_t head_ = 0;
+  volatile uint32_t enabled_ = 1;
+  TraceEvent events_[length] = {};
+
+  inline uint32_t Claim()
+  {
+#if defined(__ARM_ARCH_6M__)
+    // No LDREX/STREX on M0, so mask interrupts for the increment instead
+    uint32_t primask;
+    __asm__ volatile("mrs %0, primask\n cpsid i" : "=r"(primask)::"memory");
+    const uint32_t pos = head_++;
+    __asm__ volatile("msr primask, %0" ::"r"(primask) : "memory");
+    return pos;
+#else
+    return __atomic_fetch_add(&head_, 1, __ATOMIC_RELAXED);
+#endif
+  }
+
+  inline void Record(TRACE_EVENT type, const char *name, int16_t value)
+  {
+    if (!enabled_) return;
+    TraceEvent &event = events_[Claim() & (length - 1)];
+    event.timestamp = Source::now();
+    event.name = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(name));
+    event.type = type;
+    event.context = Source::context();
+    event.value = value;
+  }
+};
+
+template <typename Trace>
+class ScopedTraceZone {
+public:
+  DELETE_COPY_MOVE(ScopedTraceZone);
+
+  ScopedTraceZone(Trace &trace, const char *name) : trace_(trace), name_(name)
+  {
+    trace_.Begin(name_);
+  }
+  ~ScopedTraceZone() { trace_.End(name_); }
+
+private:
+  Trace &trace_;
+  const char *const name_;
+};
+
 }  // namespace util
 
+// Event name literal in the .stm32x_log section
+#define STM32X_TRACE_NAME(name)                                                 \
+  ([]() {                                                                       \
+    __attribute__((section(".stm32x_log"), used)) static const char s[] = name; \
+    return s;                                                                   \
+  }())
+
+#define STM32X_TRACE_BEGIN(trace, name) (trace).Begin(STM32X_TRACE_NAME(name))
+#define STM32X_TRACE_END(trace, name) (trace).End(STM32X_TRACE_NAME(name))
+#define STM32X_TRACE_INSTANT(trace, name) (trace).Instant(STM32X_TRACE_NAME(name))
+#define STM32X_TRACE_COUNTER(trace, name, value) (trace).Counter(STM32X_TRACE_NAME(name), value)
+#define STM32X_TRACE_SCOPE(trace, name) \
+  util::ScopedTraceZone CONCAT(stm32x_trace_zone_, __LINE__)(trace, STM32X_TRACE_NAME(name))
+
 #endif  // STM32X_UTIL_TRACEBUFFER_H_
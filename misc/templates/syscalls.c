@@ -39,7 +39,8 @@ int _read(int /*file*/, char * /*data*/, int /*len*/)
 {
   return -1;
 }
-int _write(int /*file*/, char * /*data*/, int /*len*/)
+// Weak so it can be replaced, e.g. with STM32X_LOG_WRITE_BACKEND (util/util_log_buffer.h)
+__attribute__((weak)) int _write(int /*file*/, char * /*data*/, int /*len*/)
 {
   return -1;
 }
@@ -0,0 +1,71 @@
+// Copyright 2024 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// USART TX via DMA as an asynchronous sink for util::LogBuffer. The USART (pins, baud rate, TE/UE)
+// and DMA clock are set up by the application, Init only configures the channel for
+// memory-to-peripheral transfers. No interrupts are used, the buffer polls busy() from Drain().
+
+#ifndef STM32F0_UART_DMA_SINK_H_
+#define STM32F0_UART_DMA_SINK_H_
+
+#include <stddef.h>
+
+#include "stm32f0xx.h"
+
+namespace stm32f0 {
+
+// See I2CxISR for why these are base addresses
+template <uint32_t usartx_base, uint32_t dma_channel_base>
+struct UartDmaSink {
+  inline static USART_TypeDef *USARTx() { return (USART_TypeDef *)usartx_base; }
+  inline static DMA_Channel_TypeDef *DMA_Channel() { return (DMA_Channel_TypeDef *)dma_channel_base; }
+
+  static void Init()
+  {
+    DMA_Channel()->CCR = DMA_CCR_DIR | DMA_CCR_MINC;
+    DMA_Channel()->CPAR = (uintptr_t)&USARTx()->TDR;
+    USARTx()->CR3 |= USART_CR3_DMAT;
+  }
+
+  static inline bool busy()
+  {
+    return (DMA_Channel()->CCR & DMA_CCR_EN) && DMA_Channel()->CNDTR;
+  }
+
+  static size_t Start(const char *data, size_t len)
+  {
+    if (len > DMA_CNDTR_NDT) len = DMA_CNDTR_NDT;
+    DMA_Channel()->CCR &= ~DMA_CCR_EN;
+    DMA_Channel()->CMAR = (uintptr_t)data;
+    DMA_Channel()->CNDTR = len;
+    DMA_Channel()->CCR |= DMA_CCR_EN;
+    return len;
+  }
+};
+
+}  // namespace stm32f0
+
+#endif  // STM32F0_UART_DMA_SINK_H_
@@ -29,8 +29,48 @@ namespace stm32x {
 
 void Core::Init(uint32_t systick_ticks)
 {
-  ticks_ = 0;
+  timebase_.Init(systick_ticks, SystemCoreClock / 1000000U);
   SysTick_Config(systick_ticks);
 }
 
+void Core::TicklessIdle(uint32_t idle_ticks)
+{
+  // Writing CTRL doesn't clear COUNTFLAG, so stopping and then reading CTRL catches an expiry
+  // that happens between waking and stopping.
+  static constexpr uint32_t kStopped = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+  static constexpr uint32_t kRunning = kStopped | SysTick_CTRL_ENABLE_Msk;
+
+  if (idle_ticks < 2) {
+    __WFI();
+    return;
+  }
+
+  // WFI still wakes on a pending interrupt, which then runs after the correction
+  ScopedIrqLock lock;
+  SysTick->CTRL = kStopped;
+  if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+    SysTick->CTRL = kRunning;
+    return;
+  }
+
+  const auto plan = timebase_.PlanSleep(idle_ticks, SysTick->VAL);
+  SysTick->LOAD = plan.load;
+  SysTick->VAL = 0;
+  SysTick->CTRL = kRunning;
+
+  __DSB();
+  __WFI();
+  __ISB();
+
+  SysTick->CTRL = kStopped;
+  const bool expired = SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk;
+  const auto correction = timebase_.CorrectAfterSleep(plan, expired, SysTick->VAL);
+  SysTick->LOAD = correction.load;
+  SysTick->VAL = 0;
+  SysTick->CTRL = kRunning;
+  SysTick->LOAD = timebase_.reload() - 1;  // Used from the next reload
+  timebase_.AddTicks(correction.ticks);
+  if (expired) timebase_.SetReloadPending();
+}
+
 }  // namespace stm32x
@@ -182,6 +182,10 @@ ifeq ($(ENABLE_LIBC_INIT_ARRAY),TRUE)
 	SYSTEM_DEFINES += ENABLE_LIBC_INIT_ARRAY
 endif
 
+ifeq ($(ENABLE_STACK_PAINT),TRUE)
+	SYSTEM_DEFINES += ENABLE_STACK_PAINT
+endif
+
 ifneq (,$(HSE_VALUE))
 SYSTEM_DEFINES += \
 	HSE_VALUE=$(HSE_VALUE)
@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+#
+# Pre-computed LookupTables for test_lut.cc; the generators mirror the ones in the test and must
+# produce identical values.
+
+import math
+import os
+import sys
+
+from tools import resource_compiler
+from tools.resource_compiler import float32, LookupTableResource
+
+TWO_PI = float32(6.283185307179586)
+
+def sine(i, n):
+  return float32(math.sin(float32(float32(TWO_PI * i) / n)))
+
+def expo(i, n):
+  return float32(math.pow(2.0, float32(float32(i) / n)))
+
+def sine_q15(i, n):
+  return int(float32(32767.0 * sine(i, n)))
+
+resources = [
+  {
+    'name': 'lut',
+    'type': resource_compiler.LookupTableResources,
+    'entries': [
+      LookupTableResource(sine, 256, boundary='Wrap'),
+      LookupTableResource(sine, 64, interpolation='Hermite', boundary='Wrap'),
+      LookupTableResource(expo, 100, interpolation='Lagrange'),
+      LookupTableResource(sine_q15, 128, value_type='int16_t', index_type='float', boundary='Wrap'),
+    ],
+  },
+]
+
+if __name__ == '__main__':
+  library = resource_compiler.ResourceLibrary(resources, None, 'util::test::resources', [], '')
+  resource_compiler.Process(library, os.path.splitext(sys.argv[1])[0])
@@ -0,0 +1,200 @@
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "util/util_coroutine.h"
+#include "util/util_memory_pool.h"
+
+namespace stm32x::test {
+
+struct FakeTicks {
+  static inline uint32_t time = 0;
+  static uint32_t now() { return time; }
+};
+
+using Executor = CoExecutor<4>;
+using Wheel = TimerWheel<FakeTicks>;
+
+static FrameSlab<256, 2> frames;
+static MemoryPool<512> pool;
+static PoolFrames pool_frames{pool};
+static Executor executor;
+static Wheel wheel;
+static CoSignal<Executor> dma_complete{executor};
+static CoSignal<Executor> spi_complete{executor};
+static bool flash_busy = false;
+static std::vector<std::string> trace;
+
+static void Step(int ticks = 1)
+{
+  while (ticks--) {
+    ++FakeTicks::time;
+    executor.Run();
+    wheel.Dispatch();
+  }
+}
+
+static CoTask<frames> WaitFlash()
+{
+  trace.push_back("wait flash");
+  co_await CoWaitUntil{wheel, [] { return !flash_busy; }};
+  trace.push_back("flash ready");
+}
+
+static CoTask<frames> Transaction(int id, CoSignal<Executor> &signal = dma_complete)
+{
+  trace.push_back("start " + std::to_string(id));
+  co_await signal;
+  trace.push_back("dma " + std::to_string(id));
+  co_await CoDelay{wheel, 3};
+  trace.push_back("delay " + std::to_string(id));
+  co_await WaitFlash();
+  trace.push_back("done " + std::to_string(id));
+}
+
+class TestCoroutine : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    trace.clear();
+    wheel.Init();
+    flash_busy = false;
+    pool.Free();  // PoolFrames never returns frames
+  }
+};
+
+TEST_F(TestCoroutine, Sequence)
+{
+  {
+    auto task = Transaction(1);
+    ASSERT_TRUE(task.valid());
+    EXPECT_EQ(1U, frames.available());
+    EXPECT_EQ((std::vector<std::string>{"start 1"}), trace);
+
+    Step(10);
+    EXPECT_FALSE(task.done());
+    dma_complete.Set();  // "ISR"
+    EXPECT_EQ(1U, trace.size());
+    Step();
+    EXPECT_EQ("dma 1", trace.back());
+    Step(2);
+    EXPECT_EQ("dma 1", trace.back());
+
+    flash_busy = true;
+    Step();
+    EXPECT_EQ("wait flash", trace.back());
+    EXPECT_EQ(0U, frames.available());
+    Step(5);
+    EXPECT_FALSE(task.done());
+    flash_busy = false;
+    Step();
+    EXPECT_TRUE(task.done());
+    EXPECT_EQ((std::vector<std::string>{"start 1", "dma 1", "delay 1", "wait flash",
+                                        "flash ready", "done 1"}),
+              trace);
+  }
+  EXPECT_EQ(2U, frames.available());
+}
+
+TEST_F(TestCoroutine, SignalBeforeWait)
+{
+  dma_complete.Set();
+  auto task = Transaction(2);
+  EXPECT_EQ("dma 2", trace.back());
+  Step(3);
+  EXPECT_TRUE(task.done());
+}
+
+TEST_F(TestCoroutine, FramesExhausted)
+{
+  auto first = Transaction(3, dma_complete);
+  auto second = Transaction(4, spi_complete);
+  EXPECT_TRUE(first.valid());
+  EXPECT_TRUE(second.valid());
+  auto third = Transaction(5);
+  EXPECT_FALSE(third.valid());
+  EXPECT_TRUE(third.done());
+  EXPECT_EQ((std::vector<std::string>{"start 3", "start 4"}), trace);
+
+  // Destroying a task waiting on a timer removes the timer
+  dma_complete.Set();
+  spi_complete.Set();
+  Step();
+  EXPECT_EQ((std::vector<std::string>{"start 3", "start 4", "dma 3", "dma 4"}), trace);
+  first = CoTask<frames>{};
+  EXPECT_EQ(1U, frames.available());
+
+  // Same for a polled wait in a nested task, which uses the frame just freed
+  flash_busy = true;
+  Step(3);
+  EXPECT_EQ("wait flash", trace.back());
+  EXPECT_EQ(0U, frames.available());
+  second = CoTask<frames>{};
+  EXPECT_EQ(2U, frames.available());
+
+  flash_busy = false;
+  Step(10);
+  EXPECT_EQ((std::vector<std::string>{"start 3", "start 4", "dma 3", "dma 4", "delay 4",
+                                      "wait flash"}),
+            trace);
+}
+
+template <typename Signal>
+static CoTask<frames> Wait(Signal &signal, int id)
+{
+  const bool signalled = co_await signal;
+  trace.push_back((signalled ? "signal " : "rejected ") + std::to_string(id));
+}
+
+TEST_F(TestCoroutine, SecondWaiterRejected)
+{
+  auto first = Wait(dma_complete, 1);
+  auto second = Wait(dma_complete, 2);
+  EXPECT_TRUE(second.done());
+  EXPECT_EQ((std::vector<std::string>{"rejected 2"}), trace);
+  dma_complete.Set();
+  Step();
+  EXPECT_TRUE(first.done());
+  EXPECT_EQ("signal 1", trace.back());
+}
+
+TEST_F(TestCoroutine, ExecutorFull)
+{
+  CoExecutor<1> small_executor;
+  CoSignal<CoExecutor<1>> a{small_executor};
+  CoSignal<CoExecutor<1>> b{small_executor};
+  auto first = Wait(a, 1);
+  auto second = Wait(b, 2);
+
+  EXPECT_TRUE(a.Set());
+  EXPECT_FALSE(b.Set());
+  EXPECT_EQ(1U, small_executor.Run());
+  EXPECT_TRUE(first.done());
+  EXPECT_FALSE(second.done());
+
+  // The waiter wasn't dropped, setting again schedules it
+  EXPECT_TRUE(b.Set());
+  EXPECT_EQ(1U, small_executor.Run());
+  EXPECT_TRUE(second.done());
+  EXPECT_EQ((std::vector<std::string>{"signal 1", "signal 2"}), trace);
+}
+
+static CoTask<pool_frames> Forever(int &count)
+{
+  for (;;) {
+    ++count;
+    co_await CoDelay{wheel, 10};
+  }
+}
+
+TEST_F(TestCoroutine, PoolFrames)
+{
+  int count = 0;
+  auto task = Forever(count);
+  EXPECT_TRUE(task.valid());
+  EXPECT_LT(pool.available(), 512U);
+  Step(35);
+  EXPECT_EQ(4, count);
+}
+
+}  // namespace stm32x::test
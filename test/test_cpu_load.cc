@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+#include "util/util_cpu_load.h"
+
+namespace stm32x::test {
+
+struct FakeClock {
+  static inline uint32_t time = 0;
+  static uint32_t now() { return time; }
+};
+
+using TestCpuLoad = CpuLoad<FakeClock, 2>;
+
+TEST(TestCpuLoad, Load)
+{
+  FakeClock::time = 0xfffff000;  // Wraps during the test
+  TestCpuLoad cpu_load{10000};
+  cpu_load.Init();
+
+  // 25% busy per 1000 cycle iteration
+  for (int i = 0; i < 10; ++i) {
+    FakeClock::time += 250;
+    cpu_load.Idle([] { FakeClock::time += 750; });
+  }
+  EXPECT_EQ(10000U, cpu_load.window_length());
+  EXPECT_EQ(250U, cpu_load.load());
+
+  // Saturated: no idle for 3 windows
+  FakeClock::time += 30000;
+  cpu_load.Idle([] { FakeClock::time += 100; });
+  EXPECT_EQ(30100U, cpu_load.window_length());
+  EXPECT_EQ(997U, cpu_load.load());
+}
+
+TEST(TestCpuLoad, NestedIsr)
+{
+  FakeClock::time = 0;
+  TestCpuLoad cpu_load{10000};
+  cpu_load.Init();
+
+  FakeClock::time += 1000;
+  {
+    STM32X_CPU_LOAD_ISR(cpu_load, 1);
+    FakeClock::time += 1000;
+    {
+      STM32X_CPU_LOAD_ISR(cpu_load, 0);
+      FakeClock::time += 500;
+    }
+    FakeClock::time += 500;
+  }
+  cpu_load.Idle([] { FakeClock::time += 7000; });
+
+  EXPECT_EQ(10000U, cpu_load.window_length());
+  EXPECT_EQ(300U, cpu_load.load());
+  EXPECT_EQ(50U, cpu_load.isr_load(0));
+  EXPECT_EQ(150U, cpu_load.isr_load(1));
+  EXPECT_EQ(500U, cpu_load.total_isr_cycles(0));
+  EXPECT_EQ(1500U, cpu_load.total_isr_cycles(1));
+}
+
+}  // namespace stm32x::test
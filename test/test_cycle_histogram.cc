@@ -0,0 +1,76 @@
+#include <string>
+
+#include "gtest/gtest.h"
+#include "util/util_cycle_histogram.h"
+
+namespace stm32x::test {
+
+template <typename Histogram>
+void TestBucket(uint32_t value)
+{
+  auto index = Histogram::bucket_index(value);
+  ASSERT_LT(index, Histogram::kNumBuckets);
+  EXPECT_LE(Histogram::bucket_lower_bound(index), value);
+  EXPECT_GE(Histogram::bucket_upper_bound(index), value);
+
+  // Relative width of bucket is bounded by the number of sub-buckets
+  auto width = Histogram::bucket_upper_bound(index) - Histogram::bucket_lower_bound(index);
+  EXPECT_LE(width, value / Histogram::kSubBuckets);
+}
+
+TEST(TestCycleHistogram, Buckets)
+{
+  using H2 = CycleHistogram<2>;
+  using H4 = CycleHistogram<4>;
+
+  EXPECT_EQ(124U, H2::kNumBuckets);
+  EXPECT_EQ(H2::kNumBuckets - 1, H2::bucket_index(0xffffffff));
+  EXPECT_EQ(0xffffffffU, H2::bucket_upper_bound(H2::kNumBuckets - 1));
+
+  for (uint32_t value = 0; value < 4096; ++value) {
+    TestBucket<H2>(value);
+    TestBucket<H4>(value);
+  }
+  for (uint32_t value = 4096; value < 0xfff00000; value += value / 7) {
+    TestBucket<H2>(value);
+    TestBucket<H4>(value);
+  }
+
+  // Buckets are contiguous
+  for (size_t i = 1; i < H4::kNumBuckets; ++i)
+    EXPECT_EQ(H4::bucket_upper_bound(i - 1) + 1, H4::bucket_lower_bound(i));
+}
+
+TEST(TestCycleHistogram, Percentiles)
+{
+  CycleHistogram<4> histogram;
+  EXPECT_EQ(0U, histogram.p50());
+
+  for (uint32_t i = 0; i < 10000; ++i) histogram.Push(1000 + i % 1000);
+  for (uint32_t i = 0; i < 20; ++i) histogram.Push(50000);
+
+  EXPECT_EQ(10020U, histogram.count());
+  EXPECT_EQ(50000U, histogram.max());
+  EXPECT_NEAR(1500, histogram.p50(), 1500 / 16);
+  EXPECT_NEAR(1990, histogram.p99(), 1990 / 16);
+  EXPECT_EQ(50000U, histogram.p999());
+  EXPECT_GE(histogram.p50(), 1500U);
+
+  histogram.Reset();
+  EXPECT_EQ(0U, histogram.count());
+  EXPECT_EQ(0U, histogram.max());
+}
+
+TEST(TestCycleHistogram, Dump)
+{
+  CycleHistogram<2> histogram;
+  histogram.Push(3);
+  histogram.Push(100);
+  histogram.Push(100);
+
+  std::string dump;
+  histogram.Dump([&dump](char c) { dump.push_back(c); }, "test");
+  EXPECT_EQ("test: n=3 p50=100 p99=100 p99.9=100 max=100\n3-3 1\n96-111 2\n", dump);
+}
+
+}  // namespace stm32x::test
@@ -0,0 +1,66 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "util/util_dpc_queue.h"
+
+namespace util::test {
+
+struct FakeTrigger {
+  static inline int pending = 0;
+  static void Trigger() { ++pending; }
+};
+
+struct Sample {
+  uint16_t channel;
+  uint16_t value;
+};
+
+using TestDpcQueue = DpcQueue<4, FakeTrigger>;
+
+static std::vector<uint32_t> calls;
+
+TEST(TestDpcQueue, PostAndDrain)
+{
+  TestDpcQueue dpc_queue;
+  calls.clear();
+  FakeTrigger::pending = 0;
+
+  EXPECT_TRUE(dpc_queue.Post([] { calls.push_back(1); }));
+  EXPECT_TRUE(dpc_queue.Post([](const Sample &s) { calls.push_back(s.channel << 16 | s.value); },
+                             Sample{2, 0x1234}));
+  EXPECT_TRUE(dpc_queue.Post([](const uint32_t &value) { calls.push_back(value); }, 0xdeadbeefU));
+  EXPECT_EQ(3, FakeTrigger::pending);
+  EXPECT_EQ(3U, dpc_queue.readable());
+  EXPECT_TRUE(calls.empty());
+
+  EXPECT_EQ(3U, dpc_queue.Drain());
+  EXPECT_EQ((std::vector<uint32_t>{1, 0x21234, 0xdeadbeef}), calls);
+  EXPECT_EQ(0U, dpc_queue.readable());
+}
+
+TEST(TestDpcQueue, Overflow)
+{
+  TestDpcQueue dpc_queue;
+  calls.clear();
+  for (uint32_t i = 0; i < 6; ++i)
+    dpc_queue.Post([](const uint32_t &value) { calls.push_back(value); }, i);
+  EXPECT_EQ(2U, dpc_queue.dropped());
+  EXPECT_EQ(4U, dpc_queue.Drain());
+  EXPECT_EQ((std::vector<uint32_t>{0, 1, 2, 3}), calls);
+  dpc_queue.ResetDropped();
+  EXPECT_EQ(0U, dpc_queue.dropped());
+}
+
+TEST(TestDpcQueue, PostWhileDraining)
+{
+  static TestDpcQueue dpc_queue;
+  calls.clear();
+  dpc_queue.Post([] {
+    calls.push_back(1);
+    dpc_queue.Post([] { calls.push_back(2); });
+  });
+  EXPECT_EQ(2U, dpc_queue.Drain());
+  EXPECT_EQ((std::vector<uint32_t>{1, 2}), calls);
+}
+
+}  // namespace util::test
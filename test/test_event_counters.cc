@@ -0,0 +1,52 @@
+#include "gtest/gtest.h"
+#include "util/util_event_counters.h"
+
+namespace stm32x::test {
+
+struct FakeEventSource {
+  static inline RawEventCounts raw = {};
+  static RawEventCounts Read() { return raw; }
+
+  // Advance the fake counters, the 8-bit ones wrap
+  static void Advance(uint32_t cycles, uint32_t cpi, uint32_t lsu, uint32_t fold)
+  {
+    raw.cycles += cycles;
+    raw.cpi = static_cast<uint8_t>(raw.cpi + cpi);
+    raw.lsu = static_cast<uint8_t>(raw.lsu + lsu);
+    raw.fold = static_cast<uint8_t>(raw.fold + fold);
+  }
+};
+
+TEST(TestEventCounters, Accumulate)
+{
+  FakeEventSource::raw = {0xffffff00, 250, 0, 0, 200, 0};
+  EventCounter<FakeEventSource> counter;
+
+  for (int i = 0; i < 100; ++i) {
+    FakeEventSource::Advance(200, 100, 50, 10);
+    counter.Accumulate();
+  }
+  const auto &counts = counter.counts();
+  EXPECT_EQ(20000U, counts.cycles);
+  EXPECT_EQ(10000U, counts.cpi);
+  EXPECT_EQ(5000U, counts.lsu);
+  EXPECT_EQ(1000U, counts.fold);
+  EXPECT_EQ(0U, counts.exc);
+  EXPECT_EQ(6000U, counts.instructions());
+}
+
+TEST(TestEventCounters, Scoped)
+{
+  FakeEventSource::raw = {};
+  EventCounts total;
+  for (int i = 0; i < 3; ++i) {
+    ScopedEventMeasurement<FakeEventSource> measurement{total};
+    FakeEventSource::Advance(100, 20, 10, 0);
+  }
+  EXPECT_EQ(300U, total.cycles);
+  EXPECT_EQ(60U, total.cpi);
+  EXPECT_EQ(30U, total.lsu);
+  EXPECT_EQ(210U, total.instructions());
+}
+
+}  // namespace stm32x::test
@@ -0,0 +1,93 @@
+#include <cstring>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "util/util_tracebuffer.h"
+
+namespace util::test {
+
+struct FakeTraceSource {
+  static inline uint32_t time = 0;
+  static inline uint8_t irq = 0;
+
+  static uint32_t now() { return time++; }
+  static uint8_t context() { return irq; }
+};
+
+static uint32_t NameId(const char *name)
+{
+  return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(name));
+}
+
+TEST(TestEventTrace, Record)
+{
+  FakeTraceSource::time = 100;
+  EventTrace<8, FakeTraceSource> trace;
+  EXPECT_EQ(0U, trace.size());
+
+  const char *zone = STM32X_TRACE_NAME("zone");
+  {
+    util::ScopedTraceZone scope{trace, zone};
+    FakeTraceSource::irq = 42;
+    STM32X_TRACE_COUNTER(trace, "counter", -7);
+    FakeTraceSource::irq = 0;
+  }
+  ASSERT_EQ(3U, trace.size());
+
+  EXPECT_EQ(TRACE_EVENT::BEGIN, trace.event(0).type);
+  EXPECT_EQ(NameId(zone), trace.event(0).name);
+  EXPECT_EQ(100U, trace.event(0).timestamp);
+  EXPECT_EQ(0, trace.event(0).context);
+
+  EXPECT_EQ(TRACE_EVENT::COUNTER, trace.event(1).type);
+  EXPECT_NE(NameId(zone), trace.event(1).name);
+  EXPECT_EQ(-7, trace.event(1).value);
+  EXPECT_EQ(42, trace.event(1).context);
+
+  EXPECT_EQ(TRACE_EVENT::END, trace.event(2).type);
+  EXPECT_EQ(NameId(zone), trace.event(2).name);
+  EXPECT_EQ(102U, trace.event(2).timestamp);
+}
+
+TEST(TestEventTrace, Wrap)
+{
+  FakeTraceSource::time = 0;
+  EventTrace<8, FakeTraceSource> trace;
+  for (int i = 0; i < 20; ++i) trace.Counter("i", i);
+  ASSERT_EQ(8U, trace.size());
+  for (size_t i = 0; i < trace.size(); ++i) {
+    EXPECT_EQ(12 + static_cast<int>(i), trace.event(i).value);
+  }
+
+  trace.Stop();
+  trace.Instant("ignored");
+  EXPECT_EQ(19, trace.event(7).value);
+}
+
+TEST(TestEventTrace, Dump)
+{
+  FakeTraceSource::time = 0;
+  EventTrace<4, FakeTraceSource> trace;
+  EXPECT_TRUE(trace.valid());
+  trace.Instant("a");
+  trace.Instant("b");
+
+  std::string dump;
+  auto writer = [&dump](char c) { dump.push_back(c); };
+  trace.Dump(writer);
+  ASSERT_EQ(16U + 4 * sizeof(TraceEvent), dump.size());
+
+  uint32_t header[4];
+  memcpy(header, dump.data(), sizeof(header));
+  EXPECT_EQ("TRC1"_4CCV, header[0]);
+  EXPECT_EQ(4U, header[1]);
+  EXPECT_EQ(2U, header[2]);
+  EXPECT_EQ(1U, header[3]);
+
+  TraceEvent event;
+  memcpy(&event, dump.data() + 16 + sizeof(TraceEvent), sizeof(event));
+  EXPECT_EQ(TRACE_EVENT::INSTANT, event.type);
+  EXPECT_EQ(1U, event.timestamp);
+}
+
+}  // namespace util::test
@@ -0,0 +1,115 @@
+#include "gtest/gtest.h"
+#include "stm32x/stm32x_gpio_utils.h"
+
+namespace stm32x::test {
+
+// Register layout as used by GPIO_Init/GPIO_PinAFConfig
+struct FakeGpioRegs {
+  uint32_t MODER;
+  uint32_t OTYPER;
+  uint32_t OSPEEDR;
+  uint32_t PUPDR;
+  uint32_t AFR[2];
+};
+
+enum struct MODE : uint8_t { IN = 0x00, OUT = 0x01, AF = 0x02, AN = 0x03 };
+
+template <int id>
+struct FakePort {
+  static inline FakeGpioRegs registers;
+  static inline bool clock_enabled = false;
+  static FakeGpioRegs *regs() { return &registers; }
+  static void EnableClock(bool enable) { clock_enabled = enable; }
+};
+
+template <typename port, uint16_t pin, MODE mode, uint8_t speed, uint8_t otype, uint8_t pupd,
+          uint8_t af = 0, bool enable_port_clock = false>
+struct FakeGpio {
+  using PORT = port;
+  static constexpr uint16_t Pin = pin;
+  static constexpr MODE Mode = mode;
+  static constexpr uint8_t Speed = speed;
+  static constexpr uint8_t OType = otype;
+  static constexpr uint8_t PuPd = pupd;
+  static constexpr uint8_t AF = af;
+  static constexpr bool EnablePortClock = enable_port_clock;
+
+  // Reference: per-pin init as GPIO_PinAFConfig + GPIO_Init (F4 order)
+  static void InitReference(FakeGpioRegs *regs)
+  {
+    if (MODE::AF == mode) {
+      regs->AFR[pin >> 3] &= ~(0xfU << ((pin & 7) * 4));
+      regs->AFR[pin >> 3] |= static_cast<uint32_t>(af) << ((pin & 7) * 4);
+    }
+    regs->MODER &= ~(0x3U << (pin * 2));
+    regs->MODER |= static_cast<uint32_t>(mode) << (pin * 2);
+    if (MODE::OUT == mode || MODE::AF == mode) {
+      regs->OSPEEDR &= ~(0x3U << (pin * 2));
+      regs->OSPEEDR |= static_cast<uint32_t>(speed) << (pin * 2);
+      regs->OTYPER &= ~(0x1U << pin);
+      regs->OTYPER |= static_cast<uint32_t>(otype) << pin;
+    }
+    regs->PUPDR &= ~(0x3U << (pin * 2));
+    regs->PUPDR |= static_cast<uint32_t>(pupd) << (pin * 2);
+  }
+};
+
+using PA = FakePort<0>;
+using PB = FakePort<1>;
+
+using Pins = std::tuple<FakeGpio<PA, 0, MODE::AN, 0, 0, 0>,            //
+                        FakeGpio<PB, 3, MODE::IN, 0, 0, 1>,            //
+                        FakeGpio<PA, 5, MODE::OUT, 2, 0, 0>,           //
+                        FakeGpio<PA, 9, MODE::AF, 3, 1, 1, 7>,         //
+                        FakeGpio<PB, 14, MODE::AF, 1, 0, 2, 5, true>,  //
+                        FakeGpio<PA, 15, MODE::OUT, 1, 1, 2>,          //
+                        FakeGpio<PB, 8, MODE::AF, 2, 0, 0, 12>>;
+
+template <typename... P>
+static void InitFromTuple(std::tuple<P...> *)
+{
+  InitPins<P...>();
+}
+
+template <typename... P>
+static void InitReferenceFromTuple(std::tuple<P...> *, FakeGpioRegs *pa, FakeGpioRegs *pb)
+{
+  ((P::InitReference(std::is_same_v<typename P::PORT, PA> ? pa : pb)), ...);
+}
+
+static constexpr FakeGpioRegs kResetValues = {0xa8000000, 0x0000, 0x0c000000, 0x64000000,
+                                              {0x12345678, 0x9abcdef0}};
+
+TEST(TestGpioInit, MatchesPerPinInit)
+{
+  PA::registers = kResetValues;
+  PB::registers = kResetValues;
+  FakeGpioRegs pa = kResetValues, pb = kResetValues;
+
+  InitFromTuple(static_cast<Pins *>(nullptr));
+  InitReferenceFromTuple(static_cast<Pins *>(nullptr), &pa, &pb);
+
+  for (auto [regs, expected] : {std::make_pair(PA::regs(), &pa), std::make_pair(PB::regs(), &pb)}) {
+    EXPECT_EQ(expected->MODER, regs->MODER);
+    EXPECT_EQ(expected->OTYPER, regs->OTYPER);
+    EXPECT_EQ(expected->OSPEEDR, regs->OSPEEDR);
+    EXPECT_EQ(expected->PUPDR, regs->PUPDR);
+    EXPECT_EQ(expected->AFR[0], regs->AFR[0]);
+    EXPECT_EQ(expected->AFR[1], regs->AFR[1]);
+  }
+  EXPECT_FALSE(PA::clock_enabled);
+  EXPECT_TRUE(PB::clock_enabled);
+}
+
+TEST(TestGpioInit, PortInit)
+{
+  constexpr auto init = MakePortInit<PA, FakeGpio<PA, 1, MODE::IN, 3, 1, 2>,
+                                     FakeGpio<PB, 2, MODE::OUT, 3, 1, 2>>();
+  static_assert(0xcU == init.moder_mask && 0U == init.moder);
+  static_assert(0x8U == init.pupdr);
+  static_assert(0U == init.otyper_mask && 0U == init.ospeedr_mask);
+  static_assert(0U == init.afr_mask[0] && 0U == init.afr_mask[1]);
+  EXPECT_FALSE(init.enable_clock);
+}
+
+}  // namespace stm32x::test
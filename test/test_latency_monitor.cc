@@ -0,0 +1,48 @@
+#include <string>
+
+#include "gtest/gtest.h"
+#include "util/util_latency_monitor.h"
+
+namespace stm32x::test {
+
+TEST(TestLatencyMonitor, Jitter)
+{
+  LatencyMonitor<> monitor;
+  EXPECT_EQ(0U, monitor.min());
+  EXPECT_EQ(0U, monitor.jitter());
+
+  // Mostly 12 cycles with the occasional blocked entry
+  for (int i = 0; i < 1000; ++i) monitor.Push(i % 100 ? 12 : 80);
+  monitor.Push(200);
+
+  EXPECT_EQ(1001U, monitor.count());
+  EXPECT_EQ(12U, monitor.min());
+  EXPECT_EQ(200U, monitor.max());
+  EXPECT_EQ(188U, monitor.jitter());
+  EXPECT_EQ(monitor.histogram().p99() - 12U, monitor.jitter_p99());
+  EXPECT_GE(13U, monitor.histogram().p50());  // Bucket upper bound
+
+  monitor.Reset();
+  EXPECT_EQ(0U, monitor.count());
+  EXPECT_EQ(0U, monitor.min());
+}
+
+TEST(TestLatencyMonitor, ScaledToZone)
+{
+  ProfilingZoneStats stats;
+  LatencyMonitor<> monitor{4, &stats};  // Timer at 1/4 of the CPU clock
+
+  monitor.Push(3);
+  monitor.Push(5);
+  EXPECT_EQ(12U, monitor.min());
+  EXPECT_EQ(20U, monitor.max());
+  EXPECT_EQ(2U, stats.count);
+  EXPECT_EQ(20U, stats.max);
+  EXPECT_EQ(20U, stats.last);
+
+  std::string report;
+  monitor.Report([&report](char c) { report.push_back(c); }, "irq");
+  EXPECT_EQ(0U, report.find("irq: min=12 jitter=8 jitter_p99=8\nirq: n=2"));
+}
+
+}  // namespace stm32x::test
@@ -0,0 +1,164 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "util/util_binary_log.h"
+#include "util/util_log_buffer.h"
+
+namespace util::test {
+
+// Synchronous sink that accepts at most `limit` chars per call
+struct FakeSink {
+  static inline std::string output;
+  static inline size_t limit = 0xffff;
+
+  static bool busy() { return false; }
+  static size_t Start(const char *data, size_t len)
+  {
+    len = std::min(len, limit);
+    output.append(data, len);
+    return len;
+  }
+};
+
+// Asynchronous sink, "transfer" completes when Complete is called
+struct FakeDmaSink {
+  static inline std::string output;
+  static inline const char *data = nullptr;
+  static inline size_t len = 0;
+
+  static bool busy() { return len; }
+  static size_t Start(const char *d, size_t l)
+  {
+    data = d;
+    len = l;
+    return l;
+  }
+  static void Complete()
+  {
+    output.append(data, len);
+    len = 0;
+  }
+};
+
+template <typename Buffer>
+void Write(Buffer &buffer, const std::string &s)
+{
+  buffer.Write(s.data(), s.length());
+}
+
+TEST(TestLogBuffer, Drop)
+{
+  FakeSink::output.clear();
+  LogBuffer<16, FakeSink> buffer;
+
+  Write(buffer, "0123456789\n");
+  Write(buffer, "abcdef\n");  // doesn't fit
+  EXPECT_EQ(11U, buffer.readable());
+  EXPECT_EQ(7U, buffer.dropped());
+
+  buffer.Drain();
+  EXPECT_EQ("0123456789\n", FakeSink::output);
+  EXPECT_EQ(0U, buffer.readable());
+
+  // Wraps around the end, takes two drains
+  Write(buffer, "abcdef\n");
+  buffer.Drain();
+  buffer.Drain();
+  EXPECT_EQ("0123456789\nabcdef\n", FakeSink::output);
+}
+
+TEST(TestLogBuffer, Truncate)
+{
+  FakeSink::output.clear();
+  LogBuffer<8, FakeSink, LOG_OVERFLOW::TRUNCATE> buffer;
+
+  Write(buffer, "0123456789");
+  EXPECT_EQ(8U, buffer.readable());
+  EXPECT_EQ(2U, buffer.dropped());
+  buffer.Drain();
+  EXPECT_EQ("01234567", FakeSink::output);
+}
+
+TEST(TestLogBuffer, PartialSink)
+{
+  FakeSink::output.clear();
+  FakeSink::limit = 3;
+  LogBuffer<16, FakeSink> buffer;
+
+  Write(buffer, "0123456789");
+  for (int i = 0; i < 4; ++i) buffer.Drain();
+  EXPECT_EQ("0123456789", FakeSink::output);
+  EXPECT_EQ(0U, buffer.readable());
+  FakeSink::limit = 0xffff;
+}
+
+TEST(TestLogBuffer, AsyncSink)
+{
+  FakeDmaSink::output.clear();
+  LogBuffer<16, FakeDmaSink> buffer;
+
+  Write(buffer, "0123456789");
+  buffer.Drain();
+  EXPECT_TRUE(FakeDmaSink::busy());
+
+  // In-flight data isn't released until the transfer completes
+  Write(buffer, "abcdefghij");
+  EXPECT_EQ(10U, buffer.dropped());
+  buffer.Drain();
+  FakeDmaSink::Complete();
+  buffer.Drain();
+  Write(buffer, "abcdefghij");
+  EXPECT_EQ(10U, buffer.dropped());
+
+  while (buffer.readable()) {
+    buffer.Drain();
+    if (FakeDmaSink::busy()) FakeDmaSink::Complete();
+  }
+  EXPECT_EQ("0123456789abcdefghij", FakeDmaSink::output);
+}
+
+template <typename Log>
+void LogFromTemplate(Log &log)
+{
+  STM32X_LOG(log, "template");
+}
+
+static std::vector<uint32_t> Words(const std::string &s)
+{
+  std::vector<uint32_t> words(s.length() / 4);
+  memcpy(words.data(), s.data(), words.size() * 4);
+  return words;
+}
+
+TEST(TestBinaryLog, Records)
+{
+  FakeSink::output.clear();
+  BinaryLog<64, FakeSink> log;
+
+  const char *name = "name";
+  enum { VALUE = 3 };
+  STM32X_LOG(log, "%d %u %f %s %d", -1, 2U, 0.5f, name, VALUE);
+  LogFromTemplate(log);
+  EXPECT_EQ(28U, log.readable());
+  log.Drain();
+  log.Drain();
+
+  auto words = Words(FakeSink::output);
+  ASSERT_EQ(7U, words.size());
+  EXPECT_EQ(5U, words[0] & 0xff);
+  EXPECT_EQ(0xffffffffU, words[1]);
+  EXPECT_EQ(2U, words[2]);
+  EXPECT_EQ(0x3f000000U, words[3]);
+  EXPECT_EQ(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(name)), words[4]);
+  EXPECT_EQ(3U, words[5]);
+  EXPECT_EQ(0U, words[6] & 0xff);
+
+  // Records are dropped as a whole
+  for (int i = 0; i < 20; ++i) STM32X_LOG(log, "%d", i);
+  EXPECT_EQ(64U, log.readable());
+  EXPECT_EQ(12U * 8, log.dropped());
+}
+
+}  // namespace util::test
@@ -0,0 +1,301 @@
+#include <chrono>
+#include <cmath>
+
+#include "fmt/core.h"
+#include "gtest/gtest.h"
+#include "util/util_lut.h"
+#include "util/util_lut_compressed.h"
+
+// Generated from resources/test_lut_resources.py
+#include "test_lut_resources.h"
+
+namespace util::test {
+
+static constexpr float kTwoPi = 6.283185307179586f;
+
+static LUT_GENERATOR_CONSTEXPR float sine_generator(size_t i, size_t N)
+{
+  return sinf(kTwoPi * static_cast<float>(i) / static_cast<float>(N));
+}
+
+static LUT_GENERATOR_CONSTEXPR float ramp_generator(size_t i, size_t N)
+{
+  return static_cast<float>(i) / static_cast<float>(N);
+}
+
+static LUT_GENERATOR_CONSTEXPR float expo_generator(size_t i, size_t N)
+{
+  return powf(2.f, static_cast<float>(i) / static_cast<float>(N));
+}
+
+static LUT_GENERATOR_CONSTEXPR int16_t sine_q15_generator(size_t i, size_t N)
+{
+  return static_cast<int16_t>(32767.f * sine_generator(i, N));
+}
+
+// The resource compiler mirrors the compile-time generation in gcc, a runtime libm might differ
+// slightly (e.g. clang, where the tables aren't constexpr).
+template <typename LUT>
+void ExpectSameTable(const LUT &expected, const LUT &lut)
+{
+#ifdef __clang__
+  for (size_t i = 0; i < LUT::kArraySize; ++i) EXPECT_FLOAT_EQ(expected.data_[i], lut.data_[i]);
+#else
+  EXPECT_EQ(0, memcmp(expected.data_.data(), lut.data_.data(), sizeof(lut.data_)));
+#endif
+}
+
+template <typename Interpolation, size_t N>
+float MaxSineError()
+{
+  static LUT_CONSTEXPR auto lut =
+      LookupTable<float, N, float, Interpolation, lut::Wrap>::generate(sine_generator);
+  float max_error = 0.f;
+  for (int i = 0; i < 10000; ++i) {
+    float x = static_cast<float>(i) / 10000.f;
+    max_error = std::max(max_error, fabsf(lut.read_interpolated(x) - sinf(kTwoPi * x)));
+  }
+  return max_error;
+}
+
+TEST(TestLookupTable, GuardPoints)
+{
+  EXPECT_EQ(17U, (LookupTable<float, 16, float, lut::Linear>::kArraySize));
+  EXPECT_EQ(19U, (LookupTable<float, 16, float, lut::Hermite>::kArraySize));
+  EXPECT_EQ(19U, (LookupTable<float, 16, float, lut::Lagrange>::kArraySize));
+
+  static LUT_CONSTEXPR auto clamped =
+      LookupTable<float, 16, float, lut::Hermite, lut::Clamp>::generate(ramp_generator);
+  EXPECT_EQ(0.f, clamped.data_.front());
+  EXPECT_EQ(0.f, clamped[0]);
+  EXPECT_EQ(1.f, clamped.data_[clamped.kArraySize - 2]);
+  EXPECT_EQ(1.f, clamped.data_.back());
+
+  static LUT_CONSTEXPR auto wrapped =
+      LookupTable<float, 16, float, lut::Hermite, lut::Wrap>::generate(ramp_generator);
+  EXPECT_EQ(wrapped[15], wrapped.data_.front());
+  EXPECT_EQ(wrapped[0], wrapped.data_[wrapped.kArraySize - 2]);
+  EXPECT_EQ(wrapped[1], wrapped.data_.back());
+}
+
+TEST(TestLookupTable, Read)
+{
+  static LUT_CONSTEXPR auto lut = LookupTable<float, 16>::generate(ramp_generator);
+  EXPECT_EQ(0.f, lut.read(-1.f));
+  EXPECT_EQ(lut[3], lut.read(3.5f));
+  EXPECT_EQ(lut[15], lut.read(16.f));
+  EXPECT_EQ(lut[15], lut.read(100.f));
+}
+
+TEST(TestLookupTable, Clamp)
+{
+  static LUT_CONSTEXPR auto lut = LookupTable<float, 16>::generate(ramp_generator);
+  EXPECT_FLOAT_EQ(0.f, lut.read_interpolated(-0.5f));
+  EXPECT_FLOAT_EQ(0.25f, lut.read_interpolated(0.25f));
+  EXPECT_FLOAT_EQ(0.5f + 0.5f / 16.f, lut.read_interpolated(0.5f + 0.5f / 16.f));
+  EXPECT_FLOAT_EQ(1.f, lut.read_interpolated(1.f));
+  EXPECT_FLOAT_EQ(1.f, lut.read_interpolated(2.f));
+}
+
+TEST(TestLookupTable, Wrap)
+{
+  static LUT_CONSTEXPR auto lut =
+      LookupTable<float, 64, float, lut::Linear, lut::Wrap>::generate(sine_generator);
+  EXPECT_NEAR(lut.read_interpolated(0.75f), lut.read_interpolated(-0.25f), 1e-6f);
+  EXPECT_NEAR(lut.read_interpolated(0.25f), lut.read_interpolated(1.25f), 1e-6f);
+  EXPECT_NEAR(0.f, lut.read_interpolated(1.f), 1e-6f);
+  EXPECT_NEAR(0.f, lut.read_interpolated(0.9999999f), 1e-5f);
+}
+
+TEST(TestLookupTable, Cubic)
+{
+  // Lagrange interpolation is exact for cubic polynomials (away from the edges)
+  static LUT_CONSTEXPR auto lut = LookupTable<float, 16, float, lut::Lagrange>::generate(
+      [](size_t i, size_t N) LUT_GENERATOR_CONSTEXPR {
+        float x = static_cast<float>(i) / static_cast<float>(N);
+        return x * x * x - x;
+      });
+  for (float x = 0.1f; x < 0.9f; x += 0.0173f) {
+    EXPECT_NEAR(x * x * x - x, lut.read_interpolated(x), 1e-6f);
+  }
+}
+
+TEST(TestLookupTable, Accuracy)
+{
+  auto linear = MaxSineError<lut::Linear, 256>();
+  auto hermite = MaxSineError<lut::Hermite, 64>();
+  auto lagrange = MaxSineError<lut::Lagrange, 64>();
+  fmt::println("linear[256]={:g} hermite[64]={:g} lagrange[64]={:g}", linear, hermite, lagrange);
+
+  EXPECT_LT(hermite, linear);
+  EXPECT_LT(lagrange, linear);
+}
+
+TEST(TestLookupTable, Resources)
+{
+  using resources::lut_expo_100;
+  using resources::lut_sine_256;
+  using resources::lut_sine_64;
+  using resources::lut_sine_q15_128;
+
+  static LUT_CONSTEXPR auto sine_256 =
+      std::decay_t<decltype(lut_sine_256)>::generate(sine_generator);
+  static LUT_CONSTEXPR auto sine_64 = std::decay_t<decltype(lut_sine_64)>::generate(sine_generator);
+  static LUT_CONSTEXPR auto expo_100 =
+      std::decay_t<decltype(lut_expo_100)>::generate(expo_generator);
+  static LUT_CONSTEXPR auto sine_q15_128 =
+      std::decay_t<decltype(lut_sine_q15_128)>::generate(sine_q15_generator);
+
+  ExpectSameTable(lut_sine_256, sine_256);
+  ExpectSameTable(lut_sine_64, sine_64);
+  ExpectSameTable(lut_expo_100, expo_100);
+  ExpectSameTable(lut_sine_q15_128, sine_q15_128);
+
+  static_assert(lut_sine_256.read_interpolated(0.25f) == 1.f);
+}
+
+TEST(TestLookupTable, QuarterWave)
+{
+  std::array<int16_t, 256> full;
+  for (size_t i = 0; i < full.size(); ++i)
+    full[i] = static_cast<int16_t>(lroundf(32767.f * sine_generator(i, full.size())));
+
+  QuarterWaveTable<int16_t, 256> lut{full.data()};
+  for (size_t i = 0; i < 2 * full.size(); ++i) EXPECT_NEAR(full[i % full.size()], lut[i], 1);
+}
+
+TEST(TestLookupTable, DeltaVarint)
+{
+  // resource_compiler.DeltaArrayResource('x', 'int16_t', [1000, -5, 300, 300, -32768])
+  static const uint8_t kEncoded[] = {0xd0, 0x0f, 0xd9, 0x0f, 0xe2, 0x04, 0x00, 0xd7, 0x84, 0x04};
+  static const int16_t kExpected[] = {1000, -5, 300, 300, -32768};
+
+  stm32x::MemoryPool<64> pool;
+  pool.Alloc(1);
+  auto values = ExpandDeltaVarint<int16_t>(pool, kEncoded, sizeof(kEncoded), 5);
+  ASSERT_NE(nullptr, values);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(values) % alignof(int16_t));
+  for (size_t i = 0; i < 5; ++i) EXPECT_EQ(kExpected[i], values[i]);
+
+  EXPECT_EQ(nullptr, ExpandDeltaVarint<int16_t>(pool, kEncoded, sizeof(kEncoded) - 3, 5));
+  EXPECT_EQ(nullptr, ExpandDeltaVarint<int16_t>(pool, kEncoded, sizeof(kEncoded), 64));
+
+  // Cut inside the last (3 byte) varint
+  int16_t dst[5] = {};
+  EXPECT_EQ(4U, ExpandDeltaVarint(kEncoded, sizeof(kEncoded) - 1, dst, 5));
+  EXPECT_EQ(300, dst[3]);
+  pool.Free();
+  EXPECT_EQ(nullptr, ExpandDeltaVarint<int16_t>(pool, kEncoded, sizeof(kEncoded) - 1, 5));
+
+  DeltaVarintReader reader{kEncoded, sizeof(kEncoded) - 2};
+  while (reader.available() && reader.ok()) reader.Next();
+  EXPECT_FALSE(reader.ok());
+
+  // More than 32 bits of continuation bytes
+  static const uint8_t kOverlong[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+  EXPECT_EQ(0U, ExpandDeltaVarint(kOverlong, sizeof(kOverlong), dst, 5));
+  static const uint8_t kOverlong5[] = {0xff, 0xff, 0xff, 0xff, 0x1f};
+  EXPECT_EQ(0U, ExpandDeltaVarint(kOverlong5, sizeof(kOverlong5), dst, 5));
+
+  // Largest 5 byte varints (deltas -2^31, 2^31-1) wrap the sum rather than overflow
+  static const uint8_t kLimits[] = {0xff, 0xff, 0xff, 0xff, 0x0f, 0xfe, 0xff, 0xff, 0xff, 0x0f,
+                                    0xfe, 0xff, 0xff, 0xff, 0x0f};
+  int32_t wide[3] = {};
+  EXPECT_EQ(3U, ExpandDeltaVarint(kLimits, sizeof(kLimits), wide, 3));
+  EXPECT_EQ(INT32_MIN, wide[0]);
+  EXPECT_EQ(-1, wide[1]);
+  EXPECT_EQ(INT32_MAX - 1, wide[2]);
+}
+
+static constexpr float bilinear_function(float x, float y)
+{
+  return 0.25f + 0.5f * x - 0.75f * y + x * y;
+}
+
+static constexpr float bilinear_generator(size_t x, size_t y, size_t X, size_t Y)
+{
+  return bilinear_function(static_cast<float>(x) / static_cast<float>(X),
+                           static_cast<float>(y) / static_cast<float>(Y));
+}
+
+TEST(TestLookupTable2D, Generate)
+{
+  using LUT = LookupTable2D<float, 8, 4, float, lut::Wrap, lut::Clamp>;
+  static constexpr auto lut = LUT::generate(bilinear_generator);
+  EXPECT_EQ(9U * 5U, LUT::kArraySize);
+  for (size_t y = 0; y <= 4; ++y) {
+    EXPECT_EQ(lut.row(y)[0], lut.row(y)[8]);
+    for (size_t x = 0; x < 8; ++x) EXPECT_EQ(bilinear_generator(x, y, 8, 4), lut.row(y)[x]);
+  }
+  EXPECT_EQ(lut.row(2)[3], lut.read(3, 2));
+  EXPECT_EQ(lut.read(7, 3), lut.read(100, 100));
+}
+
+TEST(TestLookupTable2D, Bilinear)
+{
+  static constexpr auto lut = LookupTable2D<float, 8, 4>::generate(bilinear_generator);
+  static constexpr auto lut_q15 = LookupTable2D<int16_t, 8, 4>::generate(
+      [](size_t x, size_t y, size_t X, size_t Y) constexpr {
+        return static_cast<int16_t>(16384.f * bilinear_generator(x, y, X, Y));
+      });
+
+  for (float y = 0.f; y < 1.f; y += 0.0625f / 3.f) {
+    for (float x = 0.f; x < 1.f; x += 0.0625f / 3.f) {
+      const uint32_t qx = static_cast<uint32_t>(x * 4294967296.f);
+      const uint32_t qy = static_cast<uint32_t>(y * 4294967296.f);
+      EXPECT_NEAR(bilinear_function(x, y), lut.read_interpolated(x, y), 1e-6f);
+      EXPECT_NEAR(bilinear_function(x, y), lut.read_interpolated_fixed(qx, qy), 1e-6f);
+      EXPECT_NEAR(16384.f * bilinear_function(x, y), lut_q15.read_interpolated_fixed(qx, qy), 2.f);
+    }
+  }
+  EXPECT_NEAR(bilinear_function(1.f, 1.f), lut.read_interpolated(1.f, 2.f), 1e-6f);
+}
+
+// Compare against the hand-rolled version of stacked 1D tables
+TEST(TestLookupTable2D, Benchmark)
+{
+  static constexpr size_t kX = 256;
+  static constexpr size_t kY = 16;
+  static constexpr size_t kIterations = 1 << 20;
+
+  static const auto lut = LookupTable2D<float, kX, kY>::generate(bilinear_generator);
+  static std::array<LookupTable<float, kX>, kY + 1> luts;
+  for (size_t y = 0; y <= kY; ++y) {
+    luts[y] = LookupTable<float, kX>::generate(
+        [y](size_t x, size_t X) { return bilinear_generator(x, y, X, kY); });
+  }
+
+  auto benchmark = [](auto &&fn) {
+    volatile float sink = 0.f;
+    float x = 0.f, y = 0.f;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kIterations; ++i) {
+      sink = fn(x, y);
+      x += 0.00731f;
+      if (x >= 1.f) x -= 1.f;
+      y += 0.000913f;
+      if (y >= 1.f) y -= 1.f;
+    }
+    (void)sink;
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / kIterations;
+  };
+
+  auto stacked_ns = benchmark([](float x, float y) {
+    y *= kY;
+    auto j = std::min(static_cast<size_t>(y), kY - 1);
+    auto a = luts[j].read_interpolated(x);
+    auto b = luts[j + 1].read_interpolated(x);
+    return a + (b - a) * (y - static_cast<float>(j));
+  });
+  auto bilinear_ns = benchmark([](float x, float y) { return lut.read_interpolated(x, y); });
+  auto fixed_ns = benchmark([](float x, float y) {
+    return lut.read_interpolated_fixed(static_cast<uint32_t>(x * 4294967296.f),
+                                       static_cast<uint32_t>(y * 4294967296.f));
+  });
+
+  fmt::println("{}x{} stacked 1D: {:.2f}ns bilinear: {:.2f}ns bilinear (fixed): {:.2f}ns", kX, kY,
+               stacked_ns, bilinear_ns, fixed_ns);
+}
+
+}  // namespace util::test
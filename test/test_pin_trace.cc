@@ -0,0 +1,74 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "stm32x/stm32x_gpio_utils.h"
+#include "util/util_pin_trace.h"
+
+namespace stm32x::test {
+
+struct FakePort {
+  static inline std::vector<uint32_t> writes;
+  static void SetReset(uint32_t bsrr) { writes.push_back(bsrr); }
+};
+
+template <uint16_t pin>
+struct FakePin {
+  using PORT = FakePort;
+  static constexpr uint16_t Pin = pin;
+  static constexpr uint16_t Mask = 1U << pin;
+};
+
+using FakeGroup = PinGroup<FakePin<4>, FakePin<5>, FakePin<6>, FakePin<7>>;
+using FakeZones = PinZoneTrace<FakeGroup>;
+
+static_assert(0x00f00000 == FakeGroup::BSRR(0));
+static_assert(0x00a00050 == FakeGroup::BSRR(5));
+static_assert(0x000000f0 == FakeGroup::BSRR(0x1f));
+
+// Bit i goes to the i-th pin, in any order
+using ScatterGroup = PinGroup<FakePin<9>, FakePin<2>, FakePin<14>>;
+static_assert(FakeGroup::ADJACENT);
+static_assert(!ScatterGroup::ADJACENT);
+static_assert(0x4204 == ScatterGroup::MASK);
+static_assert(0x0200 == ScatterGroup::Scatter(1));
+static_assert(0x4004 == ScatterGroup::Scatter(6));
+static_assert(0x42040000 == ScatterGroup::BSRR(0));
+static_assert(0x40000204 == ScatterGroup::BSRR(3));
+
+TEST(TestPinTrace, ScatterWrite)
+{
+  FakePort::writes.clear();
+  for (unsigned bits = 0; bits < 8; ++bits) ScatterGroup::Set(bits);
+  ASSERT_EQ(8U, FakePort::writes.size());
+  for (unsigned bits = 0; bits < 8; ++bits) {
+    const uint32_t bsrr = FakePort::writes[bits];
+    EXPECT_EQ(ScatterGroup::MASK, (bsrr & 0xffff) | (bsrr >> 16));  // Every pin written once
+    EXPECT_EQ(0U, (bsrr & 0xffff) & (bsrr >> 16));
+    EXPECT_EQ(bits & 1, (bsrr >> 9) & 1);
+    EXPECT_EQ((bits >> 1) & 1, (bsrr >> 2) & 1);
+    EXPECT_EQ((bits >> 2) & 1, (bsrr >> 14) & 1);
+  }
+}
+
+TEST(TestPinTrace, NestedZones)
+{
+  EXPECT_EQ(15U, FakeZones::kMaxZone);
+  FakePort::writes.clear();
+  FakeZones::Init();
+  {
+    STM32X_PIN_ZONE(FakeZones, 3);
+    EXPECT_EQ(3U, FakeZones::current());
+    {
+      STM32X_PIN_ZONE(FakeZones, 12);
+      EXPECT_EQ(12U, FakeZones::current());
+    }
+    EXPECT_EQ(3U, FakeZones::current());
+  }
+  EXPECT_EQ(0U, FakeZones::current());
+
+  std::vector<uint32_t> expected = {FakeGroup::BSRR(0), FakeGroup::BSRR(3), FakeGroup::BSRR(12),
+                                    FakeGroup::BSRR(3), FakeGroup::BSRR(0)};
+  EXPECT_EQ(expected, FakePort::writes);
+}
+
+}  // namespace stm32x::test
@@ -0,0 +1,106 @@
+#include <string>
+
+#include "gtest/gtest.h"
+#include "util/util_pc_sampler.h"
+#include "util/util_profiler.h"
+
+STM32X_PROFILE_ZONE(test_zone);
+
+namespace stm32x::test {
+
+struct StringWriter {
+  std::string *dest;
+  void operator()(char c) const { dest->push_back(c); }
+};
+
+TEST(TestProfiler, Zone)
+{
+  EXPECT_STREQ("test_zone", ::stm32x_profile_zone_test_zone.name);
+  EXPECT_EQ(&STM32X_PROFILE_ZONE_STATS(test_zone), ::stm32x_profile_zone_test_zone.stats);
+
+  auto &stats = STM32X_PROFILE_ZONE_STATS(test_zone);
+  stats.Push(800);
+  stats.Push(80);
+  EXPECT_EQ(2U, stats.count);
+  EXPECT_EQ(80U, stats.last);
+  EXPECT_EQ(800U, stats.max);
+  EXPECT_EQ(97U, stats.average);
+  stats.Reset();
+  EXPECT_EQ(0U, stats.count);
+  EXPECT_EQ(0U, stats.max);
+}
+
+TEST(TestProfiler, Report)
+{
+  ProfilingZoneStats stats[3];
+  const ProfilingZone zones[3] = {{"audio", &stats[0]}, {"ui", &stats[1]}, {"adc", &stats[2]}};
+  const ProfilingZones range{std::begin(zones), std::end(zones)};
+  EXPECT_EQ(3U, range.size());
+
+  stats[0].Push(1000);
+  stats[2].Push(16);
+  stats[2].Push(8);
+
+  std::string report;
+  Profiler::Report(range, StringWriter{&report});
+  EXPECT_EQ("audio 1 1000 125 1000\nui 0 0 0 0\nadc 2 8 2 16\n", report);
+
+  Profiler::Reset(range);
+  report.clear();
+  Profiler::Report(range, StringWriter{&report});
+  EXPECT_EQ("audio 0 0 0 0\nui 0 0 0 0\nadc 0 0 0 0\n", report);
+}
+
+TEST(TestProfiler, Exporter)
+{
+  ProfilingZoneStats stats[2];
+  const ProfilingZone zones[2] = {{"a", &stats[0]}, {"b", &stats[1]}};
+  std::string output;
+  ProfilerExporter<StringWriter> exporter{{std::begin(zones), std::end(zones)}, 100,
+                                          StringWriter{&output}};
+
+  exporter.Poll(10);
+  EXPECT_EQ("", output);
+  exporter.Poll(100);
+  EXPECT_EQ("# 100\n", output);
+  exporter.Poll(101);
+  EXPECT_EQ("# 100\na 0 0 0 0\n", output);
+  exporter.Poll(102);
+  exporter.Poll(103);
+  exporter.Poll(199);
+  EXPECT_EQ("# 100\na 0 0 0 0\nb 0 0 0 0\n", output);
+  exporter.Poll(200);
+  EXPECT_EQ("# 100\na 0 0 0 0\nb 0 0 0 0\n# 200\n", output);
+}
+
+TEST(TestPcSampler, Buckets)
+{
+  PcSampler<16, 4, uint8_t> sampler{0x08000000};
+  EXPECT_TRUE(sampler.valid());
+  EXPECT_EQ(0x08000010U, sampler.bucket_address(1));
+
+  sampler.Push(0x08000000);
+  sampler.Push(0x0800000e);
+  sampler.Push(0x08000010);
+  sampler.Push(0x080000fe);
+  sampler.Push(0x08000100);  // Past end
+  sampler.Push(0x20000000);  // RAM
+  sampler.Push(0x07fffffe);  // Before base
+  EXPECT_EQ(7U, sampler.total());
+  EXPECT_EQ(3U, sampler.other());
+  EXPECT_EQ(2U, sampler.count(0));
+  EXPECT_EQ(1U, sampler.count(1));
+  EXPECT_EQ(1U, sampler.count(15));
+
+  // Stops when a bucket is full
+  for (int i = 0; i < 300; ++i) sampler.Push(0x08000020);
+  EXPECT_FALSE(sampler.enabled());
+  EXPECT_EQ(255U, sampler.count(2));
+
+  sampler.Reset();
+  sampler.Start();
+  EXPECT_EQ(0U, sampler.total());
+  EXPECT_EQ(0U, sampler.count(2));
+}
+
+}  // namespace stm32x::test
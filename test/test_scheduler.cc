@@ -0,0 +1,109 @@
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "util/util_scheduler.h"
+
+namespace stm32x::test {
+
+struct FakeTicks {
+  static inline uint32_t time = 0;
+  static uint32_t now() { return time; }
+};
+
+struct FakeCycles {
+  static inline uint32_t time = 0;
+  static uint32_t now() { return time; }
+};
+
+static std::vector<std::string> runs;
+static uint32_t slow_task_ticks = 0;
+
+static void Fast()
+{
+  runs.push_back("fast");
+  FakeCycles::time += 10;
+}
+
+static void Slow()
+{
+  runs.push_back("slow");
+  FakeCycles::time += 100;
+  FakeTicks::time += slow_task_ticks;
+}
+
+static constexpr TaskDescriptor kTasks[] = {
+    {"slow", Slow, 4, 1, 1},
+    {"fast", Fast, 2, 0, 0},
+};
+
+using TestScheduler = Scheduler<FakeTicks, FakeCycles, kTasks>;
+
+class TestSchedulerFixture : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    FakeTicks::time = 0xfffffff0;  // Wraps during the tests
+    runs.clear();
+    slow_task_ticks = 0;
+    scheduler.Init();
+  }
+
+  TestScheduler scheduler;
+};
+
+TEST_F(TestSchedulerFixture, PeriodAndPhase)
+{
+  std::vector<uint32_t> run_count;
+  for (int i = 0; i < 32; ++i) {
+    run_count.push_back(scheduler.Dispatch());
+    ++FakeTicks::time;
+  }
+  EXPECT_EQ(8U, scheduler.stats(0).cycles.count);
+  EXPECT_EQ(16U, scheduler.stats(1).cycles.count);
+  EXPECT_EQ(100U, scheduler.stats(0).cycles.max);
+  EXPECT_EQ(10U, scheduler.stats(1).cycles.last);
+  EXPECT_EQ(0U, scheduler.stats(0).overruns);
+  EXPECT_EQ(0U, scheduler.stats(0).max_lateness);
+
+  std::vector<uint32_t> expected = {1, 1, 1, 0};
+  EXPECT_EQ(expected, std::vector<uint32_t>(run_count.begin(), run_count.begin() + 4));
+}
+
+TEST_F(TestSchedulerFixture, PriorityOrder)
+{
+  // Both due at the same time, fast has the higher priority despite its table position
+  FakeTicks::time += 5;
+  EXPECT_EQ(2U, scheduler.Dispatch());
+  EXPECT_EQ((std::vector<std::string>{"fast", "slow"}), runs);
+  EXPECT_EQ(4U, scheduler.stats(0).max_lateness);
+  EXPECT_EQ(5U, scheduler.stats(1).max_lateness);
+  EXPECT_EQ(1U, scheduler.ticks_until_next());
+}
+
+TEST_F(TestSchedulerFixture, NoDrift)
+{
+  // Late dispatch within the period doesn't move the release times
+  FakeTicks::time += 1;
+  scheduler.Dispatch();
+  FakeTicks::time += 3;
+  EXPECT_EQ(0U, scheduler.ticks_until_next());
+  scheduler.Dispatch();
+  EXPECT_EQ(1U, scheduler.ticks_until_next());
+  EXPECT_EQ(0U, scheduler.stats(0).overruns);
+}
+
+TEST_F(TestSchedulerFixture, Overrun)
+{
+  slow_task_ticks = 9;  // Misses two releases
+  FakeTicks::time += 1;
+  scheduler.Dispatch();
+  EXPECT_EQ(1U, scheduler.stats(0).overruns);
+  EXPECT_EQ(1U, scheduler.stats(1).overruns);  // Fast was starved
+
+  std::string report;
+  scheduler.Report([&report](char c) { report.push_back(c); });
+  EXPECT_EQ("slow 1 100 12 100 1 0\nfast 2 10 2 10 1 8\n", report);
+}
+
+}  // namespace stm32x::test
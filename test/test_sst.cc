@@ -0,0 +1,118 @@
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "util/util_sst.h"
+
+namespace stm32x::test {
+
+// Minimal NVIC model: pending a vector runs it immediately if its priority is higher (lower value)
+// than the active one, otherwise once the active handlers return.
+struct FakeNvic {
+  static constexpr int kNumVectors = 2;
+  static inline bool pending[kNumVectors] = {};
+  static inline int active_priority = 256;  // Thread mode
+  static inline void (*handlers[kNumVectors])() = {};
+  static inline int priorities[kNumVectors] = {};
+
+  static void Pend(int vector)
+  {
+    pending[vector] = true;
+    Schedule();
+  }
+
+  static void Schedule()
+  {
+    for (;;) {
+      int next = -1;
+      for (int i = 0; i < kNumVectors; ++i) {
+        if (pending[i] && priorities[i] < active_priority &&
+            (next < 0 || priorities[i] < priorities[next]))
+          next = i;
+      }
+      if (next < 0) return;
+      pending[next] = false;
+      const int preempted = active_priority;
+      active_priority = priorities[next];
+      handlers[next]();
+      active_priority = preempted;
+    }
+  }
+};
+
+template <int vector>
+struct FakeTrigger {
+  static void Trigger() { FakeNvic::Pend(vector); }
+};
+
+class TestSstFixture : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    fixture = this;
+    FakeNvic::active_priority = 256;
+    for (auto &p : FakeNvic::pending) p = false;
+    FakeNvic::handlers[0] = [] { fixture->audio_task.Run(); };
+    FakeNvic::handlers[1] = [] { fixture->ui_task.Run(); };
+    FakeNvic::priorities[0] = 1;
+    FakeNvic::priorities[1] = 3;
+  }
+
+  void TearDown() override
+  {
+    for (auto &h : FakeNvic::handlers) h = nullptr;
+    fixture = nullptr;
+  }
+
+  static void Audio(const int &event)
+  {
+    fixture->trace.push_back("audio " + std::to_string(event));
+  }
+
+  static void Ui(const int &event)
+  {
+    fixture->trace.push_back("ui begin " + std::to_string(event));
+    if (event == 1) fixture->audio_task.Post(10);  // Preempts
+    fixture->trace.push_back("ui end " + std::to_string(event));
+  }
+
+  static inline TestSstFixture *fixture = nullptr;
+
+  std::vector<std::string> trace;
+  SstTask<int, 4, FakeTrigger<0>> audio_task{Audio};
+  SstTask<int, 4, FakeTrigger<1>> ui_task{Ui};
+};
+
+TEST_F(TestSstFixture, Preemption)
+{
+  ui_task.Post(1);
+  EXPECT_EQ((std::vector<std::string>{"ui begin 1", "audio 10", "ui end 1"}), trace);
+
+  // Posted from a higher priority: queued, runs after the current event completes
+  trace.clear();
+  FakeNvic::active_priority = 0;
+  ui_task.Post(2);
+  ui_task.Post(3);
+  audio_task.Post(11);
+  EXPECT_TRUE(trace.empty());
+  EXPECT_EQ(2U, ui_task.queued());
+  FakeNvic::active_priority = 256;
+  FakeNvic::Schedule();
+  EXPECT_EQ((std::vector<std::string>{"audio 11", "ui begin 2", "ui end 2", "ui begin 3",
+                                      "ui end 3"}),
+            trace);
+  EXPECT_EQ(2U, ui_task.max_queued());
+}
+
+TEST_F(TestSstFixture, QueueFull)
+{
+  FakeNvic::active_priority = 0;
+  for (int i = 0; i < 6; ++i) audio_task.Post(i);
+  EXPECT_EQ(2U, audio_task.dropped());
+  EXPECT_EQ(4U, audio_task.max_queued());
+  FakeNvic::active_priority = 256;
+  FakeNvic::Schedule();
+  EXPECT_EQ(4U, trace.size());
+}
+
+}  // namespace stm32x::test
@@ -0,0 +1,58 @@
+#include <string>
+
+#include "gtest/gtest.h"
+#include "util/util_stack_monitor.h"
+
+namespace stm32x::test {
+
+static constexpr size_t kStackWords = 64;
+
+template <typename Monitor>
+void CompletePass(Monitor &monitor)
+{
+  size_t polls = 0;
+  while (!monitor.Poll(4)) ASSERT_LT(++polls, kStackWords);
+}
+
+TEST(TestStackMonitor, HighWaterMark)
+{
+  uint32_t stack[kStackWords];
+  for (auto &w : stack) w = StackMonitor::kPattern;
+
+  StackMonitor monitor{stack, stack + kStackWords};
+  EXPECT_EQ(kStackWords * 4, monitor.size());
+  EXPECT_EQ(0U, monitor.used());
+
+  // Untouched
+  CompletePass(monitor);
+  EXPECT_EQ(kStackWords * 4, monitor.headroom());
+
+  // Stack grows down from the top
+  for (size_t i = 48; i < kStackWords; ++i) stack[i] = i;
+  CompletePass(monitor);
+  EXPECT_EQ(16U * 4, monitor.used());
+  EXPECT_EQ(48U * 4, monitor.headroom());
+
+  // Stack shrinks again, but the mark stays
+  for (size_t i = 48; i < 56; ++i) stack[i] = StackMonitor::kPattern;
+  stack[40] = 0;
+  CompletePass(monitor);
+  EXPECT_EQ(24U * 4, monitor.used());
+  CompletePass(monitor);
+  EXPECT_EQ(24U * 4, monitor.used());
+
+  std::string report;
+  monitor.Report([&report](char c) { report.push_back(c); }, "main");
+  EXPECT_EQ("main 256 96 160\n", report);
+}
+
+TEST(TestStackMonitor, Overflow)
+{
+  uint32_t stack[kStackWords] = {};
+  StackMonitor monitor{stack, stack + kStackWords};
+  EXPECT_TRUE(monitor.Poll(1));
+  EXPECT_EQ(0U, monitor.headroom());
+  EXPECT_EQ(1U, monitor.passes());
+}
+
+}  // namespace stm32x::test
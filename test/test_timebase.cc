@@ -0,0 +1,209 @@
+#include <functional>
+
+#include "gtest/gtest.h"
+#include "util/util_timebase.h"
+
+namespace stm32x::test {
+
+// Simulated SysTick: counts down from reload-1 and on reload sets the ISR pending bit (cleared on
+// ISR entry) and COUNTFLAG (cleared when read). on_read runs before a value is returned, e.g. to
+// let the "ISR" run in the middle of a Timebase read.
+struct FakeSysTick {
+  static constexpr uint32_t kReload = 1000;
+  static constexpr uint32_t kMaxLoad = 0xffffff;
+  static inline uint32_t val = kReload - 1;
+  static inline bool pend = false;
+  static inline bool count_flag = false;
+  static inline std::function<void()> on_read;
+  static inline std::function<void()> on_flag_read;
+
+  static uint32_t value()
+  {
+    if (on_read) on_read();
+    return val;
+  }
+  static bool reloaded()
+  {
+    const bool flag = count_flag;
+    count_flag = false;
+    if (on_flag_read) on_flag_read();
+    return flag;
+  }
+
+  static void Advance(uint32_t cycles)
+  {
+    while (cycles--) {
+      if (!val) {
+        val = kReload - 1;
+        pend = true;
+        count_flag = true;
+      } else {
+        --val;
+      }
+    }
+  }
+};
+
+using TestTimebase = Timebase<FakeSysTick>;
+
+static void Isr(TestTimebase &timebase)
+{
+  if (FakeSysTick::pend) {
+    FakeSysTick::pend = false;
+    timebase.Tick();
+  }
+}
+
+class TestTimebaseFixture : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    FakeSysTick::val = FakeSysTick::kReload - 1;
+    FakeSysTick::pend = false;
+    FakeSysTick::count_flag = false;
+    FakeSysTick::on_read = nullptr;
+    FakeSysTick::on_flag_read = nullptr;
+    timebase.Init(FakeSysTick::kReload, 10);
+  }
+
+  TestTimebase timebase;
+};
+
+TEST_F(TestTimebaseFixture, SubTick)
+{
+  EXPECT_EQ(0U, timebase.now_cycles());
+  FakeSysTick::Advance(250);
+  EXPECT_EQ(250U, timebase.now_cycles());
+  EXPECT_EQ(25U, timebase.now_us());
+
+  // Reload without the ISR having run yet
+  FakeSysTick::Advance(800);
+  EXPECT_EQ(0U, timebase.now());
+  EXPECT_EQ(1050U, timebase.now_cycles());
+  Isr(timebase);
+  EXPECT_EQ(1U, timebase.now());
+  EXPECT_EQ(1050U, timebase.now_cycles());
+  EXPECT_EQ(1050U, timebase.cycles());
+}
+
+TEST_F(TestTimebaseFixture, IsrDuringRead)
+{
+  FakeSysTick::Advance(999);
+  uint64_t last = timebase.now_cycles();
+  EXPECT_EQ(999U, last);
+
+  // Each read advances time, the ISR runs (if pending) between some of the register reads
+  int reads = 0;
+  FakeSysTick::on_read = [&] {
+    FakeSysTick::Advance(1);
+    if (++reads % 3) Isr(timebase);
+  };
+  for (int i = 0; i < 5000; ++i) {
+    const uint64_t t = timebase.now_cycles();
+    ASSERT_GT(t, last);
+    last = t;
+  }
+}
+
+// The pending bit is cleared on ISR entry, before the handler gets to Tick(). Reads in that
+// window, by the handler itself or an ISR preempting it, still count the reload.
+TEST_F(TestTimebaseFixture, TickIsrEntry)
+{
+  FakeSysTick::Advance(1002);
+  ASSERT_TRUE(FakeSysTick::pend);
+  FakeSysTick::pend = false;  // ISR entry
+  EXPECT_EQ(1002U, timebase.now_cycles());
+  FakeSysTick::Advance(1);
+  EXPECT_EQ(1003U, timebase.now_cycles());
+  EXPECT_EQ(1003U, timebase.cycles());
+  timebase.Tick();
+  EXPECT_EQ(1U, timebase.now());
+  EXPECT_EQ(1003U, timebase.now_cycles());
+
+  // An ISR preempting Tick() just after it cleared the flag, without an earlier read having seen
+  // the reload
+  FakeSysTick::Advance(999);
+  FakeSysTick::pend = false;
+  uint64_t preempted = 0;
+  FakeSysTick::on_flag_read = [&] {
+    FakeSysTick::on_flag_read = nullptr;
+    preempted = timebase.now_cycles();
+  };
+  timebase.Tick();
+  EXPECT_EQ(2002U, preempted);
+  EXPECT_EQ(2U, timebase.now());
+  EXPECT_EQ(2002U, timebase.now_cycles());
+}
+
+TEST_F(TestTimebaseFixture, Wrap64)
+{
+  timebase.Init(FakeSysTick::kReload, 10, 0xfffffffeULL);
+  FakeSysTick::Advance(500);
+  const uint64_t start = timebase.now_cycles();
+  EXPECT_EQ(0xfffffffeULL * 1000 + 500, start);
+
+  uint64_t last = start;
+  for (int i = 0; i < 4; ++i) {
+    FakeSysTick::Advance(1000);
+    Isr(timebase);
+    const uint64_t t = timebase.now_cycles();
+    EXPECT_EQ(1000U, t - last);
+    last = t;
+  }
+  EXPECT_EQ(2U, timebase.now());
+  EXPECT_EQ(static_cast<uint32_t>(last), timebase.cycles());
+  EXPECT_EQ(last / 10, timebase.now_us());
+}
+
+TEST_F(TestTimebaseFixture, PlanSleep)
+{
+  auto plan = timebase.PlanSleep(5, 300);
+  EXPECT_EQ(5U, plan.ticks);
+  EXPECT_EQ(4300U, plan.load);
+
+  plan = timebase.PlanSleep(100000, 999);
+  EXPECT_EQ(16777U, plan.ticks);
+  EXPECT_EQ(timebase.max_sleep_ticks(), plan.ticks);
+  EXPECT_GE(FakeSysTick::kMaxLoad, plan.load);
+  EXPECT_LT(FakeSysTick::kMaxLoad, timebase.PlanSleep(plan.ticks + 1, 999).load + 1000);
+}
+
+// Simulate sleeps that end after each possible number of cycles; the corrected time should match
+// the elapsed time (the stopped timer is ignored, so no cycles are lost here).
+TEST_F(TestTimebaseFixture, TicklessCorrection)
+{
+  static constexpr uint32_t kIdleTicks = 3;
+  const uint32_t reload = FakeSysTick::kReload;
+  for (uint32_t start_value : {999U, 500U, 1U, 0U}) {
+    for (uint32_t sleep_cycles = 0; sleep_cycles < kIdleTicks * reload + 100; ++sleep_cycles) {
+      timebase.Init(reload, 10, 0xfffffffeULL);
+      FakeSysTick::val = start_value;
+      FakeSysTick::pend = false;
+      FakeSysTick::count_flag = false;
+      const uint64_t start = timebase.now_cycles();
+
+      const auto plan = timebase.PlanSleep(kIdleTicks, start_value);
+      const bool expired = sleep_cycles > plan.load;
+      const uint32_t value =
+          expired ? plan.load - (sleep_cycles - plan.load - 1) : plan.load - sleep_cycles;
+      const auto correction = timebase.CorrectAfterSleep(plan, expired, value);
+
+      ASSERT_NE(0U, correction.load);
+      ASSERT_GT(reload, correction.load);
+      FakeSysTick::val = correction.load;
+      timebase.AddTicks(correction.ticks);
+      if (expired) timebase.SetReloadPending();
+
+      // A sleep that ends exactly on a tick boundary starts the next tick a cycle early
+      const uint64_t now = timebase.now_cycles();
+      if (expired) {
+        timebase.Tick();
+        ASSERT_EQ(now, timebase.now_cycles()) << start_value << " " << sleep_cycles;
+      }
+      ASSERT_LE(start + sleep_cycles, now) << start_value << " " << sleep_cycles;
+      ASSERT_GE(start + sleep_cycles + 1, now) << start_value << " " << sleep_cycles;
+    }
+  }
+}
+
+}  // namespace stm32x::test
@@ -0,0 +1,148 @@
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "fmt/core.h"
+#include "gtest/gtest.h"
+#include "util/util_timer_wheel.h"
+
+namespace stm32x::test {
+
+struct FakeTicks {
+  static inline uint32_t time = 0;
+  static uint32_t now() { return time; }
+};
+
+struct RecordingTimer : SoftTimer {
+  RecordingTimer() : SoftTimer(Record) {}
+
+  std::vector<uint32_t> fired;
+
+  static void Record(SoftTimer &timer)
+  {
+    static_cast<RecordingTimer &>(timer).fired.push_back(FakeTicks::time);
+  }
+};
+
+using TestWheel = TimerWheel<FakeTicks, 4, 3>;  // Small levels to exercise cascading
+
+TEST(TestTimerWheel, Expiry)
+{
+  FakeTicks::time = 0xffffff00;  // Wraps during the test
+  const uint32_t start = FakeTicks::time;
+  TestWheel wheel;
+
+  // Timeouts on each level, at level boundaries and beyond the range
+  std::vector<uint32_t> timeouts = {1, 2, 15, 16, 17, 255, 256, 257, 4095, 4096, 10000};
+  std::vector<std::unique_ptr<RecordingTimer>> timers;
+  for (auto timeout : timeouts) {
+    timers.emplace_back(std::make_unique<RecordingTimer>());
+    wheel.Start(*timers.back(), timeout);
+  }
+
+  for (int i = 0; i < 12000; ++i) {
+    ++FakeTicks::time;
+    wheel.Dispatch();
+  }
+  for (size_t i = 0; i < timeouts.size(); ++i) {
+    ASSERT_EQ(1U, timers[i]->fired.size()) << timeouts[i];
+    EXPECT_EQ(start + timeouts[i], timers[i]->fired[0]) << timeouts[i];
+    EXPECT_FALSE(timers[i]->active());
+  }
+}
+
+TEST(TestTimerWheel, PeriodicAndStop)
+{
+  FakeTicks::time = 100;
+  TestWheel wheel;
+  RecordingTimer periodic, stopped;
+  wheel.Start(periodic, 5, 20);
+  wheel.Start(stopped, 10);
+
+  // Dispatch late and in bursts, expiry times are still exact
+  FakeTicks::time += 8;
+  EXPECT_EQ(1U, wheel.Dispatch());
+  wheel.Stop(stopped);
+  EXPECT_FALSE(stopped.active());
+  FakeTicks::time += 60;
+  EXPECT_EQ(3U, wheel.Dispatch());
+
+  EXPECT_EQ((std::vector<uint32_t>{108, 168, 168, 168}), periodic.fired);
+  EXPECT_TRUE(stopped.fired.empty());
+  EXPECT_TRUE(periodic.active());
+  EXPECT_EQ(185U, periodic.expires());
+}
+
+TEST(TestTimerWheel, RestartFromCallback)
+{
+  FakeTicks::time = 0;
+  static TestWheel wheel;
+  wheel.Init();
+  static int count;
+  count = 0;
+  SoftTimer timer([](SoftTimer &t) {
+    if (++count < 3) wheel.Start(t, 7);
+  });
+  wheel.Start(timer, 7);
+  for (int i = 0; i < 100; ++i) {
+    ++FakeTicks::time;
+    wheel.Dispatch();
+  }
+  EXPECT_EQ(3, count);
+  EXPECT_FALSE(timer.active());
+}
+
+// Baseline: decrement and check every timer on each tick
+struct LinearTimer {
+  uint32_t remaining = 0;
+  uint32_t period = 0;
+};
+
+TEST(TestTimerWheel, Benchmark)
+{
+  static constexpr uint32_t kTicks = 1 << 14;
+  static size_t fired = 0;
+  std::minstd_rand rng{0x1234};
+
+  for (size_t num_timers : {10, 100, 1000}) {
+    std::vector<uint32_t> periods(num_timers);
+    for (auto &period : periods) period = 10 + rng() % 2000;
+
+    std::vector<LinearTimer> linear(num_timers);
+    for (size_t i = 0; i < num_timers; ++i) linear[i] = {periods[i], periods[i]};
+    fired = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t tick = 0; tick < kTicks; ++tick) {
+      for (auto &timer : linear) {
+        if (!--timer.remaining) {
+          timer.remaining = timer.period;
+          ++fired;
+        }
+      }
+    }
+    std::chrono::duration<double, std::nano> linear_ns = std::chrono::steady_clock::now() - start;
+    const size_t linear_fired = fired;
+
+    FakeTicks::time = 0;
+    TimerWheel<FakeTicks> wheel;
+    std::vector<std::unique_ptr<SoftTimer>> timers;
+    for (size_t i = 0; i < num_timers; ++i) {
+      timers.emplace_back(std::make_unique<SoftTimer>([](SoftTimer &) { ++fired; }));
+      wheel.Start(*timers.back(), periods[i], periods[i]);
+    }
+    fired = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t tick = 0; tick < kTicks; ++tick) {
+      ++FakeTicks::time;
+      wheel.Dispatch();
+    }
+    std::chrono::duration<double, std::nano> wheel_ns = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(linear_fired, fired);
+    fmt::println("{} timers: linear scan {:.1f}ns/tick wheel {:.1f}ns/tick", num_timers,
+                 linear_ns.count() / kTicks, wheel_ns.count() / kTicks);
+  }
+}
+
+}  // namespace stm32x::test
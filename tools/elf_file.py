@@ -0,0 +1,123 @@
+#
+# Copyright 2024 Patrick Dowling
+#
+# Author: Patrick Dowling (pld@gurkenkiste.com)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+# See http://creativecommons.org/licenses/MIT/ for more information.
+#
+# -----------------------------------------------------------------------------
+#
+# Minimal ELF32 reader for the tools that need to look at the firmware image
+# (section contents, strings in flash, symbols) without further dependencies.
+
+import struct
+
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+STT_FUNC = 2
+
+
+class ElfSection(object):
+    def __init__(self, name, sh_type, flags, addr, offset, size, link):
+        self.name = name
+        self.type = sh_type
+        self.flags = flags
+        self.addr = addr
+        self.offset = offset
+        self.size = size
+        self.link = link
+
+    def contains(self, addr):
+        return self.addr <= addr < self.addr + self.size
+
+
+class ElfSymbol(object):
+    def __init__(self, name, value, size, sym_type):
+        self.name = name
+        self.value = value
+        self.size = size
+        self.type = sym_type
+
+
+class ElfFile(object):
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1:
+            raise ValueError("%s: not an ELF32 file" % path)
+        self.endian = '<' if self.data[5] == 1 else '>'
+
+        e_shoff, = self.unpack('I', 0x20)
+        e_shentsize, e_shnum, e_shstrndx = self.unpack('HHH', 0x2e)
+
+        headers = [self.unpack('IIIIIII', e_shoff + i * e_shentsize) for i in range(e_shnum)]
+        strtab_offset = headers[e_shstrndx][4]
+        self.sections = [ElfSection(self.cstring(strtab_offset + h[0]), *h[1:]) for h in headers]
+
+    def unpack(self, fmt, offset):
+        return struct.unpack_from(self.endian + fmt, self.data, offset)
+
+    def cstring(self, offset):
+        end = self.data.index(b'\0', offset)
+        return self.data[offset:end].decode('utf-8', errors='replace')
+
+    def section(self, name):
+        for section in self.sections:
+            if section.name == name:
+                return section
+        return None
+
+    def section_data(self, section):
+        return self.data[section.offset:section.offset + section.size]
+
+    def loaded_section(self, addr):
+        for section in self.sections:
+            if section.flags & SHF_ALLOC and section.type != SHT_NOBITS and section.contains(addr):
+                return section
+        return None
+
+    def read_string(self, addr):
+        """Read a string from a loaded section (e.g. .rodata in flash)"""
+        section = self.loaded_section(addr)
+        if section is None:
+            return None
+        return self.cstring(section.offset + addr - section.addr)
+
+    def symbols(self):
+        """All named symbols from .symtab"""
+        symtab = next((s for s in self.sections if s.type == SHT_SYMTAB), None)
+        if symtab is None:
+            return []
+        strtab = self.sections[symtab.link]
+        result = []
+        for offset in range(symtab.offset, symtab.offset + symtab.size, 16):
+            st_name, st_value, st_size, st_info = self.unpack('IIIB', offset)
+            if st_name:
+                name = self.cstring(strtab.offset + st_name)
+                result.append(ElfSymbol(name, st_value, st_size, st_info & 0xf))
+        return result
+
+    def functions(self):
+        """Function symbols sorted by address, with the thumb bit cleared"""
+        functions = [ElfSymbol(s.name, s.value & ~1, s.size, s.type)
+                     for s in self.symbols() if s.type == STT_FUNC]
+        return sorted(functions, key=lambda s: s.value)
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 Patrick Dowling
+#
+# Author: Patrick Dowling (pld@gurkenkiste.com)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+# See http://creativecommons.org/licenses/MIT/ for more information.
+#
+# -----------------------------------------------------------------------------
+#
+# Decoder for STM32X_LOG records (include/util/util_binary_log.h).
+# The format strings are read from the non-loaded .stm32x_log section of the
+# firmware ELF; the record header contains the offset of the string.
+#
+# usage: log_decoder.py firmware.elf capture.bin    ('-' reads from stdin)
+
+import sys
+import re
+import struct
+import argparse
+
+from elf_file import ElfFile
+
+LOG_SECTION = '.stm32x_log'
+
+# printf conversion: flags, width, precision, length (ignored), conversion
+CONVERSION = re.compile(r'%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|j|z|t|L)?([diouxXcfFeEgGsp%])')
+
+
+class LogDecoder(object):
+    def __init__(self, elf):
+        self.elf = elf
+        section = elf.section(LOG_SECTION)
+        if section is None:
+            raise ValueError("No %s section in ELF" % LOG_SECTION)
+        self.strings = elf.section_data(section)
+
+    def format_string(self, format_id):
+        if format_id >= len(self.strings):
+            return None
+        end = self.strings.find(b'\0', format_id)
+        return self.strings[format_id:end].decode('utf-8', errors='replace')
+
+    def convert(self, conversion, value):
+        if conversion in 'di':
+            return struct.unpack('<i', struct.pack('<I', value))[0]
+        if conversion in 'fFeEgG':
+            return struct.unpack('<f', struct.pack('<I', value))[0]
+        if conversion == 'c':
+            return chr(value & 0xff)
+        if conversion == 's':
+            s = self.elf.read_string(value)
+            return s if s is not None else '<0x%08x>' % value
+        return value
+
+    def format(self, fmt, args):
+        args = list(args)
+        missing = []
+
+        def replace(match):
+            spec, conversion = match.groups()
+            if conversion == '%':
+                return '%'
+            if not args:
+                missing.append(match.group(0))
+                return '<?>'
+            value = self.convert(conversion, args.pop(0))
+            if conversion == 'p':
+                return '0x%08x' % value
+            return ('%' + spec + conversion) % value
+
+        message = CONVERSION.sub(replace, fmt)
+        if args or missing:
+            message += ' <argument mismatch: %d extra, %d missing>' % (len(args), len(missing))
+        return message
+
+    def decode(self, data):
+        """Yield messages from a byte stream of records; an incomplete record at the end is ignored"""
+        pos = 0
+        while pos + 4 <= len(data):
+            header, = struct.unpack_from('<I', data, pos)
+            format_id, num_args = header >> 8, header & 0xff
+            fmt = self.format_string(format_id)
+            if fmt is None:
+                yield '<unknown format id 0x%06x, skipping word>' % format_id
+                pos += 4
+                continue
+            end = pos + 4 * (1 + num_args)
+            if end > len(data):
+                break
+            args = struct.unpack_from('<%dI' % num_args, data, pos + 4)
+            yield self.format(fmt, args)
+            pos = end
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument('elf', help='Firmware ELF file')
+    parser.add_argument('capture', help='Captured log bytes (- for stdin)')
+    args = parser.parse_args()
+
+    if args.capture == '-':
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, 'rb') as f:
+            data = f.read()
+
+    decoder = LogDecoder(ElfFile(args.elf))
+    for message in decoder.decode(data):
+        print(message)
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 Patrick Dowling
+#
+# Author: Patrick Dowling (pld@gurkenkiste.com)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+# See http://creativecommons.org/licenses/MIT/ for more information.
+#
+#
+# Flat profile from a stm32x::PcSampler dump (include/util/util_pc_sampler.h),
+# attributing each bucket to the function containing its start address using
+# the ELF symbols (i.e. $(ELFFILE) from stm32x.mk). Buckets should therefore be
+# small compared to the functions of interest.
+#
+# usage: pc_profile.py firmware.elf pc_samples.bin [-n count]
+
+import bisect
+import struct
+import argparse
+
+from elf_file import ElfFile
+
+SAMPLER_MAGIC = b'PCS1'
+HEADER = struct.Struct('<4sIIIIIII')
+COUNT_FORMATS = {1: 'B', 2: 'H', 4: 'I'}
+
+
+def read_samples(data):
+    """Return (base, shift, total, other, counts)"""
+    magic, base, shift, num_buckets, count_size, _, total, other = HEADER.unpack_from(data, 0)
+    if magic != SAMPLER_MAGIC:
+        raise ValueError("Not a PcSampler dump (magic %r)" % magic)
+    if count_size not in COUNT_FORMATS:
+        raise ValueError("Unsupported count size %d" % count_size)
+    fmt = '<%d%s' % (num_buckets, COUNT_FORMATS[count_size])
+    if HEADER.size + struct.calcsize(fmt) > len(data):
+        raise ValueError("Truncated dump, expected %d buckets" % num_buckets)
+    counts = struct.unpack_from(fmt, data, HEADER.size)
+    return base, shift, total, other, counts
+
+
+class Symbolizer(object):
+    def __init__(self, functions):
+        self.functions = functions
+        self.starts = [f.value for f in functions]
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.starts, addr) - 1
+        if i < 0:
+            return None
+        function = self.functions[i]
+        if function.size and addr >= function.value + function.size:
+            return None
+        return function.name
+
+
+def profile(symbolizer, base, shift, counts):
+    """Samples per function name"""
+    result = {}
+    for bucket, count in enumerate(counts):
+        if not count:
+            continue
+        addr = base + (bucket << shift)
+        name = symbolizer.lookup(addr) or '[0x%08x]' % addr
+        result[name] = result.get(name, 0) + count
+    return result
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument('elf', help='Firmware ELF file')
+    parser.add_argument('dump', help='PcSampler dump (gdb "dump binary value" or Dump())')
+    parser.add_argument('-n', '--count', type=int, default=0, help='Only show top n functions')
+    args = parser.parse_args()
+
+    with open(args.dump, 'rb') as f:
+        data = f.read()
+
+    base, shift, total, other, counts = read_samples(data)
+    functions = profile(Symbolizer(ElfFile(args.elf).functions()), base, shift, counts)
+
+    print("%d samples, %d outside of 0x%08x-0x%08x, %d byte buckets" %
+          (total, other, base, base + (len(counts) << shift), 1 << shift))
+    print("%7s %8s  %s" % ('%', 'samples', 'function'))
+    ranked = sorted(functions.items(), key=lambda item: item[1], reverse=True)
+    if args.count:
+        ranked = ranked[:args.count]
+    for name, count in ranked:
+        print("%6.2f%% %8d  %s" % (100.0 * count / total if total else 0, count, name))
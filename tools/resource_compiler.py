@@ -31,8 +31,26 @@
 
 import os
 import string
+import struct
 from collections import defaultdict
 
+# Round to nearest float32. Computing basic operations in double and rounding the result is
+# equivalent to doing them in float, so generators that wrap every intermediate in float32() match
+# the C++ float code bit for bit (e.g. float32(math.sin(float32(float32(TWO_PI * i) / n))) and
+# sinf(kTwoPi * i / n) as evaluated by gcc at compile time).
+def float32(x):
+  return struct.unpack('<f', struct.pack('<f', x))[0]
+
+def format_float32(x):
+  return '%.8ef' % float32(x)
+
+# Sizes of common c_types, only used for reporting
+C_TYPE_SIZES = {
+  'int8_t': 1, 'uint8_t': 1, 'char': 1,
+  'int16_t': 2, 'uint16_t': 2,
+  'int32_t': 4, 'uint32_t': 4, 'float': 4,
+}
+
 class ArrayResource(object):
   def __init__(self, name, c_type, values, formatter, values_per_line=8):
     self._name = name
@@ -40,6 +58,7 @@ class ArrayResource(object):
     self._values = values
     self._formatter = formatter
     self._values_per_line = values_per_line
+    self._raw_size = len(values) * C_TYPE_SIZES.get(c_type, 0)
 
   @property
   def name(self):
@@ -49,6 +68,22 @@ class ArrayResource(object):
   def fullname(self):
     return self._fullname
 
+  @property
+  def format(self):
+    return 'raw'
+
+  @property
+  def access(self):
+    return 'direct'
+
+  @property
+  def raw_size(self):
+    return self._raw_size
+
+  @property
+  def stored_size(self):
+    return len(self._values) * C_TYPE_SIZES.get(self._c_type, 0)
+
   def generate(self, enum, alias):
     self._enum = enum
     self._alias = alias
@@ -57,6 +92,8 @@ class ArrayResource(object):
   def compile(self, f, with_comment):
     if with_comment:
       f.write('// %s\n' % self._enum)
+    if self.format != 'raw':
+      f.write('// %s: %d -> %d bytes\n' % (self.format, self.raw_size, self.stored_size))
     f.write('static const %s %s[%d] = {' % (self._c_type, self._fullname, len(self._values)))
     num_values = len(self._values)
     if num_values > self._values_per_line:
@@ -71,6 +108,62 @@ class ArrayResource(object):
       f.write(' ')
     f.write('};\n')
 
+# Integer values stored as zigzag varint of the delta to the previous value.
+# Expand at runtime with util::DeltaVarintReader/util::ExpandDeltaVarint.
+class DeltaArrayResource(ArrayResource):
+  def __init__(self, name, c_type, values, values_per_line=16):
+    encoded = []
+    previous = 0
+    for value in values:
+      delta = int(value) - previous
+      previous = int(value)
+      zigzag = (delta << 1) if delta >= 0 else ((-delta) << 1) - 1
+      while zigzag > 0x7f:
+        encoded.append(0x80 | (zigzag & 0x7f))
+        zigzag >>= 7
+      encoded.append(zigzag)
+    super(DeltaArrayResource, self).__init__(name, 'uint8_t', encoded, lambda x: '0x%02x' % x, values_per_line)
+    self._raw_size = len(values) * C_TYPE_SIZES.get(c_type, 0)
+    self._count = len(values)
+
+  @property
+  def format(self):
+    return 'delta'
+
+  @property
+  def access(self):
+    return 'sequential/expand (%d bytes RAM)' % self.raw_size
+
+  @property
+  def count(self):
+    return self._count
+
+# Tables with quarter-wave symmetry (e.g. sine) only store the first N/4 + 1 values.
+# Access at runtime with util::QuarterWaveTable<T, N>.
+class QuarterWaveArrayResource(ArrayResource):
+  def __init__(self, name, c_type, values, formatter, values_per_line=8, tolerance=0):
+    n = len(values)
+    if n < 4 or n & (n - 1):
+      raise ValueError('%s: length %d is not a power of two >= 4' % (name, n))
+    quarter = n // 4
+    for i in range(n):
+      q, r = divmod(i, quarter)
+      expected = values[quarter - r if q & 1 else r]
+      if q & 2:
+        expected = -expected
+      if abs(values[i] - expected) > tolerance:
+        raise ValueError('%s: no quarter-wave symmetry at [%d] (%s != %s)' % (name, i, values[i], expected))
+    super(QuarterWaveArrayResource, self).__init__(name, c_type, list(values[:quarter]) + [values[quarter]], formatter, values_per_line)
+    self._raw_size = n * C_TYPE_SIZES.get(c_type, 0)
+
+  @property
+  def format(self):
+    return 'quarter-wave'
+
+  @property
+  def access(self):
+    return 'random (fold)'
+
 class ResourceTable(object):
   def __init__(self, resource):
     self._name = resource['name']
@@ -113,6 +206,10 @@ class ResourceTableEnumerated(ResourceTable):
   def declaration(self):
     return self._declaration
 
+  @property
+  def arrays(self):
+    return self._member_value_aliases
+
   @property
   def enum_name(self):
     return self._enum_name
@@ -129,7 +226,7 @@ class ResourceTableEnumerated(ResourceTable):
     if type(value) in (list, tuple):
       for i in value:
         self._generate_member_value_aliases(enum, alias, i)
-    elif type(value) == ArrayResource:
+    elif isinstance(value, ArrayResource):
       value.generate(enum, alias)
       self._member_value_aliases_lut[alias].append(value)
       self._member_value_aliases.append(value)
@@ -149,7 +246,7 @@ class ResourceTableEnumerated(ResourceTable):
   def _format_value(self, value, alias=None):
     if type(value) in (list, tuple):
       return "{ %s }" % ', '.join(self._format_value(i, alias) for i in value)
-    elif type(value) == ArrayResource:
+    elif isinstance(value, ArrayResource):
       return '%s_%s' % (alias, value.name)
     else:
       return self._formatter(value)
@@ -188,6 +285,78 @@ class ResourceTableEnumerated(ResourceTable):
         f.write('\n')
       f.write('};\n\n')
 
+# Guard points (before, after) and sample mapping matching util::lut:: in util_lut.h
+LUT_INTERPOLATION_GUARDS = {
+  'Linear': (0, 1),
+  'Hermite': (1, 2),
+  'Lagrange': (1, 2),
+}
+
+LUT_BOUNDARY_SAMPLE = {
+  'Clamp': lambda i, n: min(max(i, 0), n),
+  'Wrap': lambda i, n: i % n,
+}
+
+# Pre-computed util::LookupTable, named by generator and size (e.g. lut_sine_256).
+# generator(i, n) should mirror the C++ generator passed to LookupTable::generate.
+class LookupTableResource(object):
+  def __init__(self, generator, size, value_type='float', index_type=None,
+               interpolation='Linear', boundary='Clamp', formatter=None, name=None, values_per_line=4):
+    self._name = name if name else '%s_%d' % (generator.__name__, size)
+    self._value_type = value_type
+    self._index_type = index_type if index_type else value_type
+    self._size = size
+    self._interpolation = interpolation
+    self._boundary = boundary
+    self._values_per_line = values_per_line
+    if formatter:
+      self._formatter = formatter
+    elif value_type == 'float':
+      self._formatter = format_float32
+    else:
+      self._formatter = lambda x: '%d' % x
+
+    before, after = LUT_INTERPOLATION_GUARDS[interpolation]
+    sample = LUT_BOUNDARY_SAMPLE[boundary]
+    self._values = [generator(sample(i - before, size), size) for i in range(before + size + after)]
+
+  @property
+  def name(self):
+    return self._name
+
+  @property
+  def c_type(self):
+    return 'util::LookupTable<%s, %d, %s, util::lut::%s, util::lut::%s>' % (
+      self._value_type, self._size, self._index_type, self._interpolation, self._boundary)
+
+  def declare(self, f, prefix):
+    f.write('inline constexpr %s %s_%s = {{\n' % (self.c_type, prefix, self._name))
+    num_values = len(self._values)
+    for i in range(0, num_values, self._values_per_line):
+      f.write('  ')
+      f.write(', '.join(self._formatter(self._values[j]) for j in range(i, min(num_values, i + self._values_per_line))))
+      f.write(',\n')
+    f.write('}};\n\n')
+
+# constexpr LookupTables are defined in the header so they can be used at compile time; note that
+# there is nothing to compile into the .cc
+class LookupTableResources(object):
+  def __init__(self, resource):
+    self._prefix = resource.get('prefix', 'lut')
+    self._entries = resource['entries']
+    self._includes = ['#include "util/util_lut.h"'] + resource.get('includes', [])
+
+  @property
+  def includes(self):
+    return self._includes
+
+  def declare(self, f):
+    for entry in self._entries:
+      entry.declare(f, self._prefix)
+
+  def compile(self, f):
+    pass
+
 class ResourceLibrary(object):
   def __init__(self, resources, target, namespace, includes, header):
     self._tables = []
@@ -255,7 +424,22 @@ class ResourceLibrary(object):
       table.compile(f)
     self._close_namespace(f)
 
+  def report(self):
+    lines = []
+    for table in self._tables:
+      for array in getattr(table, 'arrays', []):
+        if array.format == 'raw':
+          continue
+        lines.append('%-32s %-12s %8d %8d %8d  %s' % (
+          array.fullname, array.format, array.raw_size, array.stored_size,
+          array.raw_size - array.stored_size, array.access))
+    if lines:
+      lines.insert(0, '%-32s %-12s %8s %8s %8s  %s' % ('array', 'format', 'raw', 'stored', 'saved', 'access'))
+    return lines
+
 # Acutal processor function
 def Process(library, basename):
   library.generate_h(basename)
   library.generate_cc(basename)
+  for line in library.report():
+    print(line)
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 Patrick Dowling
+#
+# Author: Patrick Dowling (pld@gurkenkiste.com)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+# See http://creativecommons.org/licenses/MIT/ for more information.
+#
+#
+# Convert a util::EventTrace dump (include/util/util_tracebuffer.h) to Chrome
+# trace JSON (chrome://tracing, ui.perfetto.dev). Each execution context
+# (thread mode, exception number) becomes a thread so ISR preemption shows up
+# on the timeline. Event names are read from the .stm32x_log section.
+#
+# usage: trace_to_chrome.py firmware.elf trace.bin -o trace.json [--cpu-freq Hz]
+
+import sys
+import json
+import struct
+import argparse
+
+from elf_file import ElfFile
+from log_decoder import LogDecoder
+
+TRACE_MAGIC = b'TRC1'
+HEADER = struct.Struct('<4sIII')
+EVENT = struct.Struct('<IIBBh')
+PHASES = {0: 'B', 1: 'E', 2: 'i', 3: 'C'}
+
+
+def read_events(data):
+    """Return events (timestamp, name, type, context, value) oldest first"""
+    magic, length, head, enabled = HEADER.unpack_from(data, 0)
+    if magic != TRACE_MAGIC:
+        raise ValueError("Not an EventTrace dump (magic %r)" % magic)
+    if HEADER.size + length * EVENT.size > len(data):
+        raise ValueError("Truncated dump, expected %d events" % length)
+    count = min(head, length)
+    events = []
+    for i in range(head - count, head):
+        events.append(EVENT.unpack_from(data, HEADER.size + (i % length) * EVENT.size))
+    return events
+
+
+def unwrap_timestamps(events):
+    """Extend 32-bit cycle counts; events are nearly in order, so use the signed delta"""
+    if not events:
+        return []
+    result = []
+    previous = events[0][0]
+    total = 0
+    for event in events:
+        delta = (event[0] - previous) & 0xffffffff
+        if delta >= 0x80000000:
+            delta -= 0x100000000
+        total += delta
+        previous = event[0]
+        result.append(total)
+    return result
+
+
+def context_name(context):
+    if context == 0:
+        return 'main'
+    if context < 16:
+        return 'exception %d' % context
+    return 'IRQ %d' % (context - 16)
+
+
+def convert(decoder, events, cpu_freq):
+    trace_events = []
+    contexts = set()
+    for event, cycles in zip(events, unwrap_timestamps(events)):
+        _, name_id, event_type, context, value = event
+        name = decoder.format_string(name_id)
+        if name is None:
+            name = '0x%06x' % name_id
+        contexts.add(context)
+        entry = {
+            'name': name,
+            'ph': PHASES.get(event_type, 'i'),
+            'ts': cycles * 1e6 / cpu_freq,
+            'pid': 0,
+            'tid': context,
+        }
+        if event_type == 2:
+            entry['s'] = 't'
+        elif event_type == 3:
+            entry['args'] = {name: value}
+        trace_events.append(entry)
+
+    # Chrome expects events sorted by time; claiming a slot and taking the timestamp isn't atomic
+    trace_events.sort(key=lambda e: e['ts'])
+    for context in sorted(contexts):
+        trace_events.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': context,
+                             'args': {'name': context_name(context)}})
+    return {'traceEvents': trace_events, 'displayTimeUnit': 'ns'}
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument('elf', help='Firmware ELF file')
+    parser.add_argument('dump', help='EventTrace dump (gdb "dump binary value" or Dump())')
+    parser.add_argument('-o', '--output', help='Output JSON file (default: stdout)')
+    parser.add_argument('--cpu-freq', type=float, default=168e6, help='Timestamp frequency in Hz')
+    args = parser.parse_args()
+
+    with open(args.dump, 'rb') as f:
+        data = f.read()
+
+    events = read_events(data)
+    trace = convert(LogDecoder(ElfFile(args.elf)), events, args.cpu_freq)
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(trace, f, indent=1)
+    else:
+        json.dump(trace, sys.stdout, indent=1)
+    print("%d events" % len(events), file=sys.stderr)